@@ -0,0 +1,33 @@
+#version 400 core
+precision mediump float;
+
+in vec2 texPos;
+
+out vec4 color;
+
+uniform sampler2D screen;
+// Part of the texture the scene was rendered to
+uniform float scale;
+// Between the taps, in pixels, across or down
+uniform vec2 spacing;
+
+// Gaussian weights of the center and the taps on each side
+const float weights[5] = float[](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+
+void main() {
+	vec2 texel = 1.0 / vec2(textureSize(screen, 0));
+	vec2 halfTexel = 0.5 * texel;
+	vec2 uv = texPos * scale;
+
+	vec3 sum = texture(screen, clamp(uv, halfTexel, vec2(scale) - halfTexel)).rgb * weights[0];
+	for (int i = 1; i < 5; i++) {
+		vec2 delta = spacing * texel * float(i);
+
+		sum += texture(screen, clamp(uv + delta, halfTexel, vec2(scale) - halfTexel)).rgb *
+			   weights[i];
+		sum += texture(screen, clamp(uv - delta, halfTexel, vec2(scale) - halfTexel)).rgb *
+			   weights[i];
+	}
+
+	color = vec4(sum, 1.0);
+}
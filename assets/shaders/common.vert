@@ -3,14 +3,14 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexPos;
+// Per instance, takes up the locations 3 to 6
+layout (location = 3) in mat4 model;
 
 out vec3 normal;
 out vec3 fragPos;
 out vec2 texPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+#include "frame.glsl"
 
 void main() {
 	normal = mat3(transpose(inverse(model))) * aNormal;
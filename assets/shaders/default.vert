@@ -1,10 +1,10 @@
 #version 400 core
 
 layout (location = 0) in vec3 aPos;
+// Per instance, takes up the locations 3 to 6
+layout (location = 3) in mat4 model;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+#include "frame.glsl"
 
 void main() {
 	gl_Position = proj * view * model * vec4(aPos, 1.0f);
@@ -0,0 +1,21 @@
+// Per frame data, written once a frame by the renderer into its ring buffer
+// Mirrors FrameData in renderer.cpp with the std140 layout, keep them in sync
+// Everything is highp, the block has to match between the stages on GLES
+
+struct DirLight {
+	highp vec3 direction;
+
+	highp vec3 ambient;
+	highp vec3 diffuse;
+	highp vec3 specular;
+};
+
+layout (std140) uniform Frame {
+	highp mat4 view;
+	highp mat4 proj;
+	highp vec3 viewPos;
+
+	DirLight dirLight;
+	// The cluster slice of a view depth is log(depth) * x + y
+	highp vec2 lightSlicing;
+};
@@ -7,30 +7,37 @@ out vec4 color;
 
 uniform sampler2D screen;
 
-uniform int width;
-uniform int height;
+// Part of the screen texture the scene was rendered to
+uniform float scale;
+// From the normalized device coordinates of the window to the ones of the scene, homogeneous
+uniform mat3 reprojection;
+
+// Post processing merged into the blit by the render graph
+#ifdef EXPOSURE
+uniform float exposure;
+#endif
+#ifdef VIGNETTE
+uniform float vignette;
+#endif
 
 void main() {
-	vec2 fragCoord = gl_FragCoord.xy / vec2(width, height);
-	vec2 center = vec2(0.5, 0.5); 
-	float d = length(fragCoord - center);
-	vec2 uv = texPos;
-	
-	// uv = uv * 2.0f - 1.0f; // 4 textures
-	// vec2 offset = uv.yx / 5.0f; // offset?
-	// uv = uv + uv * offset * offset;
-	// uv = uv * 0.5f + 0.5f;
-
-	if (int(gl_FragCoord.x) % 4 == 0) {
-		color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-		// return;
-	}
-	if (int(gl_FragCoord.y) % 4 == 0) {
-		color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-		// return;
-	}
-
-	color = vec4(vec3(texture(screen, uv)), 1.0f);
-} 
+	// Stay half a texel inside, so the filtering doesn't pull in what wasn't rendered this frame
+	vec2 halfTexel = 0.5 / vec2(textureSize(screen, 0));
+	// Where the scene saw what the window shows here, the edge is stretched past the scene
+	vec3 scene = reprojection * vec3(texPos * 2.0 - 1.0, 1.0);
+	vec2 sceneTexPos = scene.xy / max(scene.z, 1e-4) * 0.5 + 0.5;
+	vec2 uv = clamp(sceneTexPos * scale, halfTexel, vec2(scale) - halfTexel);
+
+	vec3 rgb = texture(screen, uv).rgb;
+
+#ifdef EXPOSURE
+	rgb *= exposure;
+#endif
+#ifdef VIGNETTE
+	// Darker towards the corners of the window, 0.5 is the squared distance of a corner
+	vec2 fromCenter = texPos - 0.5;
+	rgb *= 1.0 - vignette * dot(fromCenter, fromCenter) * 2.0;
+#endif
+
+	color = vec4(rgb, 1.0f);
+}
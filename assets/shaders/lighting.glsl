@@ -0,0 +1,99 @@
+// Shared lighting code, expects shininess, texPos, texture_diffuse0 and texture_specular0
+// to be declared before being included
+// Only the functions of the enabled lights are compiled, DIR_LIGHT for the light of the Frame block
+// and LIGHTS for the point and spot lights binned into clusters by the LightManager
+
+#include "frame.glsl"
+
+#ifdef DIR_LIGHT
+vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
+	vec3 lightDir = normalize(-light.direction);
+
+	float diff	= max(dot(normal, lightDir), 0.0f) * 1.9;
+
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float spec	= pow(max(dot(viewDir, reflectDir), 0.0f), shininess);
+
+	vec3 ambient  = light.ambient * vec3(texture(texture_diffuse0, texPos));
+	vec3 diffuse  = light.diffuse * diff * vec3(texture(texture_diffuse0, texPos));
+	vec3 specular = light.specular * spec * vec3(texture(texture_specular0, texPos));
+
+	return ambient + diffuse + specular;
+}
+#endif
+
+#ifdef LIGHTS
+// Mirror LightManager, keep them in sync
+const int CLUSTERS_X = 16;
+const int CLUSTERS_Y = 9;
+const int CLUSTERS_Z = 24;
+const int MAX_LIGHTS = 256;
+const int INDEX_WIDTH = 1024;
+
+// Mirrors LightData in lightManager.cpp, spot lights fade out from cutOff to outerCutOff
+struct Light {
+	highp vec3 position;
+	highp float range;
+	highp vec3 direction;
+	highp float cutOff;
+	highp vec3 color;
+	highp float outerCutOff;
+	// Constant, linear and quadratic
+	highp vec3 attenuation;
+};
+
+layout (std140) uniform Lights {
+	Light lights[MAX_LIGHTS];
+};
+
+// Offset and count into the indices of every cluster, the indices of the lights of all of them
+uniform highp usampler2D lightGrid;
+uniform highp usampler2D lightIndices;
+
+vec3 calcLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor,
+			   vec3 specularColor) {
+	vec3 lightDir = normalize(light.position - fragPos);
+
+	float diff = max(dot(normal, lightDir), 0.0);
+
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+	// Cut off at the range, where it is too dim to see, so the clusters don't show
+	float distance = length(light.position - fragPos);
+	float attenuation = step(distance, light.range) /
+		dot(light.attenuation, vec3(1.0, distance, distance * distance));
+
+	float theta = dot(lightDir, normalize(-light.direction));
+	float epsilon = max(light.cutOff - light.outerCutOff, 0.0001);
+	float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+	return light.color * (diff * diffuseColor + spec * specularColor) * attenuation * intensity;
+}
+
+// Only the lights of the cluster the fragment is in
+vec3 calcLights(vec3 normal, vec3 fragPos, vec3 viewDir) {
+	highp vec4 clip = proj * view * vec4(fragPos, 1.0);
+	highp vec2 tile = (clip.xy / clip.w * 0.5 + 0.5) * vec2(CLUSTERS_X, CLUSTERS_Y);
+
+	// w is the view depth
+	ivec3 cluster = ivec3(clamp(ivec2(tile), ivec2(0), ivec2(CLUSTERS_X - 1, CLUSTERS_Y - 1)),
+						  clamp(int(log(clip.w) * lightSlicing.x + lightSlicing.y), 0,
+								CLUSTERS_Z - 1));
+	// The offsets go past what a mediump int holds
+	highp uvec2 range =
+		texelFetch(lightGrid, ivec2(cluster.x, cluster.z * CLUSTERS_Y + cluster.y), 0).rg;
+
+	vec3 diffuseColor = texture(texture_diffuse0, texPos).rgb;
+	vec3 specularColor = texture(texture_specular0, texPos).rgb;
+
+	vec3 result = vec3(0.0);
+	for (highp int i = int(range.x); i < int(range.x + range.y); i++) {
+		uint index = texelFetch(lightIndices, ivec2(i % INDEX_WIDTH, i / INDEX_WIDTH), 0).r;
+
+		result += calcLight(lights[index], normal, fragPos, viewDir, diffuseColor, specularColor);
+	}
+
+	return result;
+}
+#endif
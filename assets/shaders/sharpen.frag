@@ -0,0 +1,28 @@
+#version 400 core
+precision mediump float;
+
+in vec2 texPos;
+
+out vec4 color;
+
+uniform sampler2D screen;
+// Part of the texture the scene was rendered to
+uniform float scale;
+// 0 leaves the image as it is
+uniform float amount;
+
+// Unsharp mask of the four neighbours, it brings back some of the detail lost to upscaling
+void main() {
+	vec2 texel = 1.0 / vec2(textureSize(screen, 0));
+	vec2 halfTexel = 0.5 * texel;
+	vec2 uv = texPos * scale;
+
+	vec3 center = texture(screen, clamp(uv, halfTexel, vec2(scale) - halfTexel)).rgb;
+	vec3 neighbours =
+		texture(screen, clamp(uv + vec2(texel.x, 0.0), halfTexel, vec2(scale) - halfTexel)).rgb +
+		texture(screen, clamp(uv - vec2(texel.x, 0.0), halfTexel, vec2(scale) - halfTexel)).rgb +
+		texture(screen, clamp(uv + vec2(0.0, texel.y), halfTexel, vec2(scale) - halfTexel)).rgb +
+		texture(screen, clamp(uv - vec2(0.0, texel.y), halfTexel, vec2(scale) - halfTexel)).rgb;
+
+	color = vec4(max(center * (1.0 + 4.0 * amount) - neighbours * amount, 0.0), 1.0);
+}
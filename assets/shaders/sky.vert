@@ -4,9 +4,7 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 texPos;
 
-// uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+#include "frame.glsl"
 
 void main() {
 	texPos = aPos;
@@ -0,0 +1,369 @@
+// Microbenchmarks of the engine hot paths, built with -DBENCHMARKS=ON (needs HEADLESS)
+// Usage: ./PanoramaBench [--output results.json] [--filter name]
+//
+// Every case runs a warmup and then SAMPLES batches of its iterations, the statistics are over the
+// per iteration times of the batches. The median and the median absolute deviation are the numbers
+// to compare, the minimum and p95 show how noisy the machine was
+
+#include "actors/actor.hpp"
+#include "components/cameraComponent.hpp"
+#include "components/lightComponent.hpp"
+#include "components/modelComponent.hpp"
+#include "components/movementComponent.hpp"
+#include "game.hpp"
+#include "managers/lightManager.hpp"
+#include "opengl/cubemap.hpp"
+#include "opengl/mesh.hpp"
+#include "opengl/occlusionCuller.hpp"
+#include "opengl/renderQueue.hpp"
+#include "opengl/renderer.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/types.hpp"
+#include "options.hpp"
+#include "third_party/glad/glad.h"
+#include "threadPool.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+static constexpr unsigned int SAMPLES = 30;
+
+struct Result {
+	std::string name;
+	unsigned int iterations;
+	// Nanoseconds per iteration
+	double min;
+	double median;
+	double p95;
+	double mad;
+};
+
+static double median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+
+	const size_t half = values.size() / 2;
+	return values.size() % 2 == 0 ? (values[half - 1] + values[half]) / 2.0 : values[half];
+}
+
+class Suite {
+  public:
+	explicit Suite(const std::string& filter) : mFilter(filter) {}
+
+	// GL cases finish every batch, so that the GPU work is in the time too
+	template <typename Function>
+	void run(const char* name, unsigned int iterations, bool gl, Function&& function) {
+		if (!mFilter.empty() && std::string_view(name).find(mFilter) == std::string_view::npos) {
+			return;
+		}
+
+		for (unsigned int i = 0; i < std::max(iterations / 10, 1u); i++) {
+			function();
+		}
+		if (gl) {
+			glFinish();
+		}
+
+		std::vector<double> samples;
+		samples.reserve(SAMPLES);
+
+		for (unsigned int sample = 0; sample < SAMPLES; sample++) {
+			const auto start = std::chrono::steady_clock::now();
+
+			for (unsigned int i = 0; i < iterations; i++) {
+				function();
+			}
+			if (gl) {
+				glFinish();
+			}
+
+			const std::chrono::duration<double, std::nano> time =
+				std::chrono::steady_clock::now() - start;
+			samples.emplace_back(time.count() / iterations);
+		}
+
+		std::vector<double> sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+
+		Result result = {name, iterations, sorted.front(), median(sorted), 0.0, 0.0};
+		result.p95 = sorted[static_cast<size_t>(std::ceil(0.95 * sorted.size())) - 1];
+
+		std::vector<double> deviations;
+		for (const double value : samples) {
+			deviations.emplace_back(std::abs(value - result.median));
+		}
+		result.mad = median(deviations);
+
+		SDL_Log("%-32s %12.1f ns  ±%5.1f%%  (min %.1f, p95 %.1f)", name, result.median,
+				result.median > 0.0 ? result.mad / result.median * 100.0 : 0.0, result.min,
+				result.p95);
+
+		mResults.emplace_back(std::move(result));
+	}
+
+	bool write(const std::string& file) const {
+		std::string out = "{\n  \"unit\": \"ns\",\n  \"samples\": " + std::to_string(SAMPLES) +
+						  ",\n  \"results\": [\n";
+
+		char line[512];
+		for (size_t i = 0; i < mResults.size(); i++) {
+			const Result& result = mResults[i];
+
+			std::snprintf(line, sizeof(line),
+						  "    {\"name\": \"%s\", \"iterations\": %u, \"min\": %.2f, \"median\": "
+						  "%.2f, \"p95\": %.2f, \"mad\": %.2f}%s\n",
+						  result.name.data(), result.iterations, result.min, result.median,
+						  result.p95, result.mad, i + 1 < mResults.size() ? "," : "");
+			out += line;
+		}
+
+		out += "  ]\n}\n";
+
+		if (!SDL_SaveFile(file.data(), out.data(), out.size())) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write %s: %s\n", file.data(),
+						 SDL_GetError());
+
+			return false;
+		}
+
+		return true;
+	}
+
+  private:
+	std::string mFilter;
+	std::vector<Result> mResults;
+};
+
+static void benchmark(Game& game, Suite& suite) {
+	/* Shader::set */ {
+		const Shader* shader = game.getShader("framebuffer.vert", "framebuffer.frag");
+		shader->activate();
+
+		suite.run("Shader::set int", 10000, false, [shader] { shader->set("screen", 0); });
+		suite.run("Shader::set float", 10000, false, [shader] { shader->set("scale", 0.75f); });
+		suite.run("Shader::set missing", 10000, false, [shader] { shader->set("missing", 1.0f); });
+	}
+
+	/* Mesh */ {
+		const std::vector<Vertex> vertices = {
+			{{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+			{{+1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
+			{{-1.0f, +1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+			{{+1.0f, +1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+		};
+		const std::vector<unsigned int> indices = {0, 1, 2, 1, 3, 2};
+
+		suite.run("Mesh::Mesh", 1000, true, [&vertices, &indices] {
+			const Mesh mesh(vertices, indices, {});
+		});
+
+		const Mesh mesh(vertices, indices, {});
+		game.getShader("framebuffer.vert", "framebuffer.frag")->activate();
+
+		suite.run("Mesh::bind + draw", 10000, true, [&mesh] {
+			mesh.bind();
+			mesh.draw();
+		});
+	}
+
+	/* Textures */ {
+		Cubemap cubemap(game.fullPath("textures" SEPARATOR "skybox" SEPARATOR));
+		cubemap.load();
+
+		// Decodes and uploads the six faces
+		suite.run("Cubemap::reload", 1, true, [&cubemap] { cubemap.reload(); });
+	}
+
+	/* Models */ {
+		Actor* actor = new Actor(&game);
+		ModelComponent* model =
+			new ModelComponent(actor, game.fullPath("models" SEPARATOR "untitled.obj"));
+
+		// Imports and converts every mesh
+		suite.run("ModelComponent::load", 1, true, [model] { model->load(); });
+		// The game deletes the actors
+	}
+
+	/* Camera */ {
+		CameraComponent* camera = game.getRenderer()->getCamera();
+
+		suite.run("CameraComponent::view", 100000, false, [camera] { camera->view(); });
+		suite.run("CameraComponent::project", 100000, false, [camera] { camera->project(); });
+	}
+
+	/* RenderQueue */ {
+		const std::vector<Vertex> vertices = {
+			{{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+			{{+1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
+			{{-1.0f, +1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+		};
+		const Mesh mesh(vertices, {0, 1, 2}, {});
+		Shader* shader = game.getShader("framebuffer.vert", "framebuffer.frag");
+		CameraComponent* camera = game.getRenderer()->getCamera();
+
+		// A cube of quads around the camera, about half of them in view
+		std::vector<Eigen::Affine3f> models;
+		for (unsigned int i = 0; i < 10000; i++) {
+			models.emplace_back(Eigen::Translation3f(static_cast<float>(i % 22) - 10.5f,
+													 static_cast<float>(i / 22 % 22) - 10.5f,
+													 static_cast<float>(i / 484) - 10.5f));
+		}
+
+		// The same work in the same lanes, by only the calling thread and by every core
+		for (const unsigned int threads : {1u, 0u}) {
+			ThreadPool workers(threads);
+			RenderQueue queue(workers);
+
+			const char* name = threads == 1 ? "RenderQueue x10000 serial"
+											: "RenderQueue x10000 parallel";
+			suite.run(name, 10, false, [&models, &mesh, shader, camera, &workers, &queue] {
+				const size_t lanes = workers.chunks(models.size(), 16);
+				queue.clear(camera->getOwner()->getPosition(), camera->getFar(), lanes);
+
+				workers.run(models.size(), lanes, [&](size_t lane, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; i++) {
+						queue.getLane(lane).push(100, shader, &mesh, models[i]);
+					}
+				});
+
+				queue.cull(camera->getProjectionMatrix().matrix() *
+						   camera->getViewMatrix().matrix());
+				queue.sort();
+			});
+		}
+
+		// A wall right in front of the camera hiding almost all of the quads
+		const std::vector<Vertex> wallVertices = {
+			{{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+			{{+1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
+			{{-1.0f, +1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+			{{+1.0f, +1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+		};
+		const Mesh wall(wallVertices, {0, 1, 2, 1, 3, 2}, {});
+		const Eigen::Affine3f wallModel = camera->getViewMatrix().inverse() *
+										  Eigen::Translation3f(0.0f, 0.0f, -1.5f) *
+										  Eigen::Scaling(4.0f);
+		const Eigen::Matrix4f viewProjection =
+			camera->getProjectionMatrix().matrix() * camera->getViewMatrix().matrix();
+
+		ThreadPool workers(0);
+		RenderQueue queue(workers);
+		OcclusionCuller occlusion;
+
+		suite.run("OcclusionCuller::rasterize", 1000, false, [&] {
+			occlusion.begin(viewProjection, camera->getNear());
+			occlusion.add(wall, wallModel);
+			occlusion.rasterize(workers);
+		});
+		suite.run("RenderQueue x10000 occluded", 10, false, [&] {
+			const size_t lanes = workers.chunks(models.size(), 16);
+			queue.clear(camera->getOwner()->getPosition(), camera->getFar(), lanes);
+
+			workers.run(models.size(), lanes, [&](size_t lane, size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					queue.getLane(lane).push(100, shader, &mesh, models[i]);
+				}
+			});
+
+			queue.cull(viewProjection, &occlusion);
+			queue.sort();
+		});
+	}
+
+	/* Lights */ {
+		CameraComponent* camera = game.getRenderer()->getCamera();
+		LightManager* lights = game.getRenderer()->getLights();
+
+		// A grid in front of the camera, most of them in view
+		for (unsigned int i = 0; i < LightManager::MAX_LIGHTS; i++) {
+			Actor* actor = new Actor(&game);
+			actor->setPosition(Eigen::Vector3f(static_cast<float>(i % 16) - 7.5f,
+											   static_cast<float>(i / 16 % 4),
+											   -2.0f - static_cast<float>(i / 64) * 4.0f));
+
+			LightComponent* light = new LightComponent(actor);
+			light->setAttenuation(1.0f, 0.7f, 1.8f);
+		}
+
+		suite.run("LightManager::update x256", 1000, false, [camera, lights] {
+			lights->update(camera->getViewMatrix(), camera->getProjectionMatrix().matrix(),
+						   camera->getNear(), camera->getFar());
+		});
+	}
+
+	/* Actors */ {
+		std::vector<Actor*> actors;
+		for (unsigned int i = 0; i < 10000; i++) {
+			Actor* actor = new Actor(&game);
+			MovementComponent* movement = new MovementComponent(actor);
+			movement->setForwardSpeed(1.0f);
+			movement->setAngularSpeed(0.5f);
+
+			actors.emplace_back(actor);
+		}
+
+		suite.run("Actor::update x10000", 10, false, [&actors] {
+			for (Actor* actor : actors) {
+				actor->update(1.0f / 60.0f);
+			}
+		});
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string output;
+	std::string filter;
+
+	for (int i = 1; i < argc; i += 2) {
+		const std::string_view arg = argv[i];
+
+		if (arg == "--output" && i + 1 < argc) {
+			output = argv[i + 1];
+		} else if (arg == "--filter" && i + 1 < argc) {
+			filter = argv[i + 1];
+		} else {
+			SDL_Log("Usage: ./PanoramaBench [--output results.json] [--filter name]");
+
+			return 1;
+		}
+	}
+
+	if (!SDL_Init(SDL_INIT_EVENTS | SDL_INIT_TIMER)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to init SDL: %s\n", SDL_GetError());
+
+		return 1;
+	}
+
+	Options options;
+	options.pano = "skybox";
+	options.width = 256;
+	options.height = 256;
+
+	int status = 0;
+	try {
+		Game game(options);
+		Suite suite(filter);
+
+		benchmark(game, suite);
+
+		if (!output.empty() && !suite.write(output)) {
+			status = 1;
+		}
+	} catch (const std::exception& error) {
+		SDL_Log("Error: %s", error.what());
+
+		status = 1;
+	}
+
+	SDL_Quit();
+
+	return status;
+}
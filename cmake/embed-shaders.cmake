@@ -0,0 +1,71 @@
+# Preprocesses the shaders and embeds them into a header as constexpr tables
+# Usage: cmake -DSHADER_DIR=<dir> -DOUTPUT=<header> [-DGLES=ON] -P embed-shaders.cmake
+#
+# `#include "file"` is resolved relative to SHADER_DIR (every file is included once),
+# and the `#version` line is replaced by the one of the target
+
+get_filename_component(SHADER_DIR "${SHADER_DIR}" ABSOLUTE)
+
+if(GLES)
+	set(VERSION "#version 300 es")
+else()
+	set(VERSION "#version 400 core")
+endif()
+
+function(preprocess name out)
+	file(READ "${SHADER_DIR}/${name}" content)
+
+	string(REGEX REPLACE "#version[^\n]*\n" "" content "${content}")
+
+	string(REGEX MATCHALL "#include \"[^\"]+\"" includes "${content}")
+	foreach(include IN LISTS includes)
+		string(REGEX REPLACE "#include \"([^\"]+)\"" "\\1" file "${include}")
+
+		list(FIND INCLUDED "${file}" index)
+		if(NOT index EQUAL -1)
+			set(included "")
+		else()
+			list(APPEND INCLUDED "${file}")
+			preprocess("${file}" included)
+		endif()
+
+		string(REPLACE "${include}" "${included}" content "${content}")
+	endforeach()
+
+	set(INCLUDED "${INCLUDED}" PARENT_SCOPE)
+	set(${out} "${content}" PARENT_SCOPE)
+endfunction()
+
+file(GLOB SHADERS RELATIVE "${SHADER_DIR}" "${SHADER_DIR}/*.vert" "${SHADER_DIR}/*.frag")
+list(SORT SHADERS)
+list(LENGTH SHADERS COUNT)
+
+set(TABLE "")
+foreach(shader IN LISTS SHADERS)
+	set(INCLUDED "")
+	preprocess("${shader}" source)
+
+	string(FIND "${source}" ")glsl\"" clash)
+	if(NOT clash EQUAL -1)
+		message(FATAL_ERROR "${shader}: Shader contains the raw string delimiter")
+	endif()
+
+	string(APPEND TABLE "\t{\"${shader}\", R\"glsl(${VERSION}\n${source})glsl\"},\n")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"#pragma once
+
+// Generated by cmake/embed-shaders.cmake from assets/shaders, do not edit
+
+#include <array>
+#include <string_view>
+#include <utility>
+
+constexpr std::array<std::pair<std::string_view, std::string_view>, ${COUNT}> EMBEDDED_SHADERS = {{
+${TABLE}}};
+")
+
+# Only touch the header when it changed, so that editing a shader doesn't rebuild everything
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
@@ -29,13 +29,13 @@ class Actor {
 	void setState(const State& state) { mState = state; }
 
 	[[nodiscard]] const Eigen::Vector3f& getPosition() const { return mPosition; }
-	void setPosition(const Eigen::Vector3f& pos) { mPosition = pos; }
+	void setPosition(const Eigen::Vector3f& pos);
 
 	[[nodiscard]] float getScale() const { return mScale; }
-	void setScale(float scale) { mScale = scale; }
+	void setScale(float scale);
 
 	[[nodiscard]] const Eigen::Quaternionf& getRotation() const { return mRotation; }
-	void setRotation(const Eigen::Quaternionf& rotation) { mRotation = rotation; }
+	void setRotation(const Eigen::Quaternionf& rotation);
 
 	[[nodiscard]] Eigen::Vector3f getForward() const {
 		return mRotation.toRotationMatrix() * Eigen::Vector3f::UnitX();
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Drives the camera along a path with a fixed timestep and times every frame, so that runs on
+// different versions and machines can be compared
+class Benchmark {
+  public:
+	// start is when loading began, in SDL ticks
+	explicit Benchmark(class Game* game, std::unique_ptr<class CameraPath> path, uint64_t start);
+	Benchmark(Benchmark&&) = delete;
+	Benchmark(const Benchmark&) = delete;
+	Benchmark& operator=(Benchmark&&) = delete;
+	Benchmark& operator=(const Benchmark&) = delete;
+	~Benchmark();
+
+	// Seconds of game time every frame, whatever the frame took
+	static constexpr float STEP = 1.0f / 60.0f;
+	// Frames left out of the statistics, the first ones compile shaders and fill the caches
+	static constexpr unsigned int WARMUP = 10;
+
+	// Frames it takes to go along the whole path
+	[[nodiscard]] unsigned int getFrames() const;
+
+	// Moves the camera to where it is on the path after time steps, before the actors update
+	void update(class CameraComponent* camera, unsigned int step) const;
+	// After every drawn frame
+	void frame();
+
+	// Writes the JSON report and logs the summary
+	bool report(const std::string& file) const;
+
+  private:
+	class Game* mOwner;
+	std::unique_ptr<class CameraPath> mPath;
+
+	uint64_t mStart;
+	float mLoadTime;
+	float mFirstFrame;
+
+	// Milliseconds between the ends of the frames
+	std::vector<float> mTimes;
+	uint64_t mLast;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "third_party/Eigen/Geometry"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Camera keyframes over time, interpolated linearly and spherically for the rotation
+// Stored as text, one "time x y z qw qx qy qz fov" line per key with the time in seconds and the
+// vertical field of view in degrees, lines starting with # are skipped
+class CameraPath {
+  public:
+	CameraPath() = default;
+	CameraPath(CameraPath&&) = delete;
+	CameraPath(const CameraPath&) = delete;
+	CameraPath& operator=(CameraPath&&) = delete;
+	CameraPath& operator=(const CameraPath&) = delete;
+	~CameraPath() = default;
+
+	struct Key {
+		float time;
+		Eigen::Vector3f position;
+		Eigen::Quaternionf rotation;
+		float fov;
+	};
+
+	// Turns once around the start pose in 20 seconds, zooming in and back out on the way
+	static std::unique_ptr<CameraPath> orbit(const Eigen::Vector3f& position,
+											 const Eigen::Quaternionf& rotation, float fov);
+	// Logs and returns nullptr on unreadable or malformed files
+	static std::unique_ptr<CameraPath> load(const std::string& file);
+	bool save(const std::string& file) const;
+
+	// Keys have to be added in order of time
+	void add(const Key& key) { mKeys.emplace_back(key); }
+
+	// Clamped to the first and last key, the path can't be empty
+	[[nodiscard]] Key sample(float time) const;
+	[[nodiscard]] float getDuration() const { return mKeys.empty() ? 0.0f : mKeys.back().time; }
+	[[nodiscard]] bool empty() const { return mKeys.empty(); }
+
+  private:
+	std::vector<Key> mKeys;
+};
@@ -3,6 +3,8 @@
 #include "components/component.hpp"
 #include "third_party/Eigen/Geometry"
 
+#include <cstdint>
+
 class CameraComponent : public Component {
   public:
 	explicit CameraComponent(class Actor* owner, int priority = 200);
@@ -12,9 +14,18 @@ class CameraComponent : public Component {
 	CameraComponent& operator=(const CameraComponent&) = delete;
 	~CameraComponent() override = default;
 
+	// Turns by the mouse and gamepad, on the main thread since the update can run on another
+	void input(const uint8_t* keystate) override;
 	void update(float delta) override;
+	// Turns by the mouse and gamepad motion up to now and updates the view, called by the renderer
+	// right before the frame is written in low latency mode instead of in update
+	void latch();
 
+	// Vertical, in degrees
 	void setFOV(float fov) { mFOV = fov; }
+	[[nodiscard]] float getFOV() const { return mFOV; }
+	float getNear() const { return mNear; }
+	float getFar() const { return mFar; }
 
 	void project();
 	void view();
@@ -25,8 +36,16 @@ class CameraComponent : public Component {
 	Eigen::Affine3f getProjectionMatrix() { return mProjectionMatrix; };
 
   private:
+	// Turns by the motion since the last look
+	void look();
+
 	float mFOV;
+	float mNear;
+	float mFar;
 
 	Eigen::Affine3f mViewMatrix;
 	Eigen::Affine3f mProjectionMatrix;
+
+	// When the camera last turned, in SDL ticks
+	uint64_t mLooked;
 };
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "components/component.hpp"
+#include "opengl/renderQueue.hpp"
+#include "opengl/types.hpp"
+#include "third_party/Eigen/Geometry"
 
 #include <string>
 
@@ -13,25 +16,44 @@ class DrawComponent : public Component {
 	DrawComponent& operator=(const DrawComponent&) = delete;
 	~DrawComponent() override = default;
 
-	virtual void draw() = 0;
+	// Push a packet for every mesh to draw this frame. Runs on the worker threads, so only read
+	virtual void record(RenderQueue::Lane& lane) = 0;
+	// Add the meshes to the occlusion culler, only called on the occluders
+	virtual void occlude(class OcclusionCuller& culler) = 0;
 
 	int getDrawOrder() const { return mDrawOrder; }
 
 	void setVisible(bool visible) { mVisible = visible; }
 	bool getVisible() const { return mVisible; }
 
+	// Things drawn relative to the camera, like the sky, can't be frustum culled
+	void setCullable(bool cullable) { mCullable = cullable; }
+	bool getCullable() const { return mCullable; }
+
+	// Large and simple drawables, like walls and terrain, which hide what is behind them
+	void setOccluder(bool occluder) { mOccluder = occluder; }
+	bool isOccluder() const { return mOccluder; }
+
 	void setVert(const std::string& vert) { mVert = vert; reload(); }
 	void setFrag(const std::string& frag) { mFrag = frag; reload(); }
+	// Request the shader permutation with exactly these features
+	void setDefines(const ShaderDefines& defines) { mDefines = defines; reload(); }
+	void setDefine(const std::string& name, const std::string& value = "") { mDefines[name] = value; reload(); }
 	class Shader* getShader() const { return mShader; };
 
 	void reload();
 
   protected:
+	Eigen::Affine3f getModelMatrix() const;
+
 	int mDrawOrder;
 	bool mVisible;
+	bool mCullable;
+	bool mOccluder;
 
 	std::string mVert;
 	std::string mFrag;
+	ShaderDefines mDefines;
 
 	class Shader* mShader;
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "components/component.hpp"
+#include "third_party/Eigen/Geometry"
+
+// Point light at the owner, or a spot light along its forward, binned into the clusters of the
+// view by the renderer's LightManager every frame
+class LightComponent : public Component {
+  public:
+	explicit LightComponent(class Actor* owner);
+	LightComponent(LightComponent&&) = delete;
+	LightComponent(const LightComponent&) = delete;
+	LightComponent& operator=(LightComponent&&) = delete;
+	LightComponent& operator=(const LightComponent&) = delete;
+	~LightComponent() override;
+
+	void setColor(const Eigen::Vector3f& color);
+	[[nodiscard]] const Eigen::Vector3f& getColor() const { return mColor; }
+
+	// Constant, linear and quadratic falloff over the distance
+	void setAttenuation(float constant, float linear, float quadratic);
+	[[nodiscard]] const Eigen::Vector3f& getAttenuation() const { return mAttenuation; }
+	// Where the light gets too dim to show up in 8 bits, the light is cut off there
+	[[nodiscard]] float getRange() const { return mRange; }
+
+	// Full brightness inside of inner, fading out until outer, in degrees
+	void setSpot(float inner, float outer);
+	void setPoint();
+	[[nodiscard]] bool isSpot() const { return mSpot; }
+	// Cosines of the half angles, -1 for point lights
+	[[nodiscard]] float getCutOff() const { return mCutOff; }
+	[[nodiscard]] float getOuterCutOff() const { return mOuterCutOff; }
+
+	void setEnabled(bool enabled) { mEnabled = enabled; }
+	[[nodiscard]] bool isEnabled() const { return mEnabled; }
+
+	[[nodiscard]] Eigen::Vector3f getPosition() const;
+	[[nodiscard]] Eigen::Vector3f getDirection() const;
+
+  private:
+	void range();
+
+	Eigen::Vector3f mColor;
+	Eigen::Vector3f mAttenuation;
+	float mRange;
+
+	bool mSpot;
+	float mCutOff;
+	float mOuterCutOff;
+
+	bool mEnabled;
+};
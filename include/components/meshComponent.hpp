@@ -3,6 +3,7 @@
 #include "components/drawComponent.hpp"
 #include "opengl/types.hpp"
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -16,7 +17,8 @@ class MeshComponent : public DrawComponent {
 	MeshComponent& operator=(const MeshComponent&) = delete;
 	~MeshComponent() override = default;
 
-	void draw() override;
+	void record(RenderQueue::Lane& lane) override;
+	void occlude(class OcclusionCuller& culler) override;
 
   private:
 	std::unique_ptr<class Mesh> mMesh;
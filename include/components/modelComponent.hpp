@@ -3,6 +3,8 @@
 #include "components/drawComponent.hpp"
 #include "opengl/types.hpp"
 
+#include <string>
+#include <utility>
 #include <vector>
 #include <assimp/material.h>
 
@@ -15,14 +17,22 @@ class ModelComponent : public DrawComponent {
 	ModelComponent& operator=(const ModelComponent&) = delete;
 	~ModelComponent();
 
-	void draw() override;
+	void record(RenderQueue::Lane& lane) override;
+	void occlude(class OcclusionCuller& culler) override;
 
 	void addTexture(std::pair<class Texture*, TextureType> texture);
 
+	// Imports the model again, the textures added stay
+	void load();
+	[[nodiscard]] const std::string& getPath() const { return mPath; }
+
   private:
 	void loadNode(struct aiNode* node, const struct aiScene* scene);
 	void loadMesh(struct aiMesh* mesh, const struct aiScene* scene);
 	std::vector<class Texture*> loadTextures(struct aiMaterial* mat, const aiTextureType type);
 
 	std::vector<class Mesh*> mMeshes;
+	std::vector<std::pair<class Texture*, TextureType>> mTextures;
+
+	std::string mPath;
 };
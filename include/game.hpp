@@ -1,19 +1,22 @@
 #pragma once
 
+#include "opengl/types.hpp"
+#include "options.hpp"
 #include "utils.hpp"
 
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
-#ifdef DEBUG
-#include <filesystem>
-#endif
-
 class Game {
   public:
-	Game(std::string pano);
+	explicit Game(const Options& options);
 	Game(Game&&) = delete;
 	Game(const Game&) = delete;
 	Game& operator=(Game&&) = delete;
@@ -23,17 +26,29 @@ class Game {
 	int iterate();
 	int event(const union SDL_Event& event);
 
+	// Throws off the main thread, actors update on their own thread so they make actors with spawn
 	void addActor(class Actor* actor);
 	void removeActor(class Actor* actor);
+	// Runs make on the main thread once the update is done. Actors made in an update, and the
+	// components added to them, go through here since drawables and lights need the main thread
+	void spawn(std::function<void()> make);
 
 	[[nodiscard]] int getWidth() const;
 	[[nodiscard]] int getHeight() const;
 
 	void pause() { mPaused = true; }
+	// Draws the next frames, everything that changes what is on screen calls this
+	void redraw() { mRedraw = REDRAW_FRAMES; }
 
 	class Texture* getTexture(const std::string& name);
-	class Shader* getShader(const std::string& vert, const std::string& frag);
+	class Shader* getShader(const std::string& vert, const std::string& frag,
+							const ShaderDefines& defines = {});
 	class Renderer* getRenderer() { return mRenderer; }
+	[[nodiscard]] const Options& getOptions() const { return mOptions; }
+	// nullptr unless this is a benchmark run
+	[[nodiscard]] class Benchmark* getBenchmark() const { return mBenchmark.get(); }
+	// The first gamepad connected, nullptr without one
+	[[nodiscard]] struct SDL_Gamepad* getGamepad() const { return mGamepad; }
 
 	inline std::string fullPath(const std::string& path) const {
 		return (mBasePath + "assets" + SEPARATOR + path);
@@ -41,10 +56,20 @@ class Game {
 
   private:
 	void input();
+	// Can run on the update thread, which has no GL context. Actors are made with spawn and
+	// removed by setting them dead, both are applied by reap
 	void update();
+	// Runs the spawns of the update and deletes the dead actors, on the main thread since that
+	// makes and releases GL objects
+	void reap();
+	// After the assets reload, before the next frame is drawn
+	void resnapshot();
 	void gui();
 	void draw();
 	void setup();
+	void startBenchmark(uint64_t start);
+
+	Options mOptions;
 
 	std::unique_ptr<class TextureManager> mTextures;
 	std::unique_ptr<class ShaderManager> mShaders;
@@ -54,13 +79,49 @@ class Game {
 	std::vector<class Actor*> mActors;
 	std::vector<class Actor*> mPendingActors;
 	bool mUpdatingActors;
+	std::vector<std::function<void()>> mSpawns;
+	std::thread::id mMainThread;
 
 	uint64_t mTicks;
 	std::string mBasePath;
 
 	bool mPaused;
 
+	// Frames left to draw, a few after every change so that ImGui and the GPU timings settle
+	unsigned int mRedraw;
+	static constexpr unsigned int REDRAW_FRAMES = 3;
+	// Frames drawn so far
+	unsigned int mFrame;
+	// Updates run so far. Every frame draws the one update after the last, but pipelined the
+	// update of a frame runs while the one before is drawn, so this is the frame it is for
+	unsigned int mUpdates;
+
+	struct SDL_Gamepad* mGamepad;
+
+	std::unique_ptr<class Benchmark> mBenchmark;
+	// Camera keys since F6 was pressed, nullptr while not recording
+	std::unique_ptr<class CameraPath> mRecording;
+	float mRecordingTime;
+
+	// Updates the actors of the next frame while the renderer draws the snapshot of the last one
+	// Without it everything runs in order on the main thread
+	void updater();
+	void startUpdate();
+	// Rethrows what the update threw
+	void finishUpdate();
+
+	std::thread mUpdater;
+	std::mutex mUpdateMutex;
+	std::condition_variable mUpdateCondition;
+	bool mUpdatePending;
+	bool mUpdaterRunning;
+	std::exception_ptr mUpdateError;
+	// The renderer has a snapshot of the last update, so the next one can run while it is drawn
+	bool mSnapshotted;
+
 #ifdef DEBUG
-	std::filesystem::file_time_type last_time;
+	std::unique_ptr<class FileWatcher> mWatcher;
+
+	void reloadAssets();
 #endif
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(__linux__) || defined(__ANDROID__)
+#include <condition_variable>
+#include <filesystem>
+#endif
+
+// Watches the asset directories on a thread and queues the changed files,
+// so the frame loop only has to check an atomic
+class FileWatcher {
+  public:
+	enum Type { SHADER, TEXTURE, MODEL };
+
+	struct Event {
+		Type type;
+		// Relative to the directory of the type, e.g. "skybox/right.jpg"
+		std::string file;
+
+		bool operator==(const Event& other) const = default;
+	};
+
+	// path is the base path, the same as the managers get
+	explicit FileWatcher(const std::string& path);
+	FileWatcher(FileWatcher&&) = delete;
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(FileWatcher&&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+	~FileWatcher();
+
+	[[nodiscard]] bool pending() const { return mPending.load(std::memory_order_acquire); }
+	// Takes the queued events, every file is only reported once
+	std::vector<Event> poll();
+
+  private:
+	void run();
+	void push(Type type, const std::string& file);
+
+	std::string mPath;
+
+	std::mutex mMutex;
+	std::vector<Event> mEvents;
+	std::atomic<bool> mPending;
+	std::atomic<bool> mRunning;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+	struct Directory {
+		Type type;
+		// Relative to the directory of the type, empty or ending with a separator
+		std::string prefix;
+	};
+
+	void watch(const std::string& directory, Type type, const std::string& prefix);
+
+	int mInotify;
+	// Written to on destruction to wake up the thread
+	int mWake[2];
+
+	std::unordered_map<int, Directory> mWatches;
+#else
+	void scan(bool report);
+
+	std::condition_variable mStop;
+	std::unordered_map<std::string, std::filesystem::file_time_type> mLastEdit;
+#endif
+
+	std::thread mThread;
+};
@@ -2,6 +2,10 @@
 
 #include <SDL3/SDL.h>
 
+#ifdef HEADLESS
+#include <EGL/egl.h>
+#endif
+
 class GLManager {
 public:
 	GLManager();
@@ -12,11 +16,30 @@ public:
 	~GLManager();
 
 	static void printInfo();
+
+#ifdef HEADLESS
+	// Creates a context without a window through EGL, everything is drawn into framebuffers
+	void bindContext();
+#else
 	void bindContext(SDL_Window* window);
 
 	SDL_GLContext getContext() const { return mContext; }
+#endif
+
+	// Go through EGL when headless, SDL's video subsystem isn't initialized then
+	static SDL_FunctionPointer getProcAddress(const char* name);
+	static bool extensionSupported(const char* name);
 
 private:
+	// Loads glad and sets the state every context starts with
+	static void setup();
+
+#ifdef HEADLESS
+	EGLDisplay mDisplay;
+	EGLContext mContext;
+	// Only used when the driver can't make a context current without a surface
+	EGLSurface mSurface;
+#else
 	SDL_GLContext mContext;
+#endif
 };
-
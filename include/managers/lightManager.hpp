@@ -0,0 +1,93 @@
+#pragma once
+
+#include "opengl/frameSync.hpp"
+#include "third_party/Eigen/Dense"
+#include "third_party/glad/glad.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Clustered forward lighting. The view is split into CLUSTERS_X x CLUSTERS_Y tiles on the screen
+// and CLUSTERS_Z slices getting exponentially deeper, every frame the lights are binned into the
+// clusters their bounds touch. Fragments only loop over the lights of their cluster, so shading
+// grows with the lights reaching a pixel instead of all the lights in the scene
+// GLES 3.0 has no storage buffers, the lights are a uniform block and the clusters are integer
+// textures, a set per frame in flight
+class LightManager {
+  public:
+	LightManager();
+	LightManager(LightManager&&) = delete;
+	LightManager(const LightManager&) = delete;
+	LightManager& operator=(LightManager&&) = delete;
+	LightManager& operator=(const LightManager&) = delete;
+	~LightManager();
+
+	// Mirrored in lighting.glsl
+	static constexpr unsigned int CLUSTERS_X = 16;
+	static constexpr unsigned int CLUSTERS_Y = 9;
+	static constexpr unsigned int CLUSTERS_Z = 24;
+	static constexpr unsigned int CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+	// Lights in view, the block is the 16 KiB every implementation has to allow
+	static constexpr unsigned int MAX_LIGHTS = 256;
+	// The light indices of all clusters, in rows of INDEX_WIDTH
+	static constexpr unsigned int INDEX_WIDTH = 1024;
+	static constexpr unsigned int MAX_INDICES = INDEX_WIDTH * 128;
+
+	// Size of the Lights block
+	static constexpr GLsizeiptr BLOCK_SIZE = MAX_LIGHTS * 64;
+
+	void add(class LightComponent* light);
+	void remove(class LightComponent* light);
+
+	// Bins the enabled lights into the clusters of the camera, the projection has to be symmetric
+	// Everything the frame needs is taken from the lights here, write and bind don't read them
+	void update(const Eigen::Affine3f& view, const Eigen::Matrix4f& projection, float near,
+				float far);
+	// Fills the Lights block with the lights in view, BLOCK_SIZE bytes
+	void write(void* block) const;
+	// Uploads the clusters into this frame's textures and binds them
+	void bind();
+
+	// The slice of a view depth is log(depth) * x + y
+	[[nodiscard]] const Eigen::Vector2f& getSlicing() const { return mSlicing; }
+
+	struct Stats {
+		unsigned int lights;
+		unsigned int visible;
+		unsigned int indices;
+		// Most lights in a cluster
+		unsigned int busiest;
+	};
+	[[nodiscard]] Stats getStats() const { return mStats; }
+
+  private:
+	// Recomputes the cluster bounds when the projection changes
+	void bounds(const Eigen::Matrix4f& projection, float near, float far);
+
+	std::vector<class LightComponent*> mLights;
+	// In the order of the Lights block
+	std::vector<const class LightComponent*> mVisible;
+
+	// View space box of every cluster as min x, y, z and max x, y, z, x changes fastest
+	std::array<Eigen::ArrayXf, 6> mBounds;
+	// Projection scale, near and far the bounds are for
+	Eigen::Vector4f mBoundsFor;
+	Eigen::Vector2f mSlicing;
+
+	// Cluster << 8 | light for every light in a cluster, sorted by cluster into the indices
+	std::vector<uint32_t> mHits;
+	std::vector<uint32_t> mCounts;
+	// Offset and count of every cluster
+	std::vector<uint32_t> mGrid;
+	std::vector<uint8_t> mIndices;
+	// The Lights block of the lights in view
+	std::vector<uint8_t> mBlock;
+
+	std::array<GLuint, FrameSync::FRAMES> mGridTextures;
+	std::array<GLuint, FrameSync::FRAMES> mIndexTextures;
+
+	Stats mStats;
+	// Warn only once when lights are dropped
+	bool mDropped;
+};
@@ -1,11 +1,10 @@
 #pragma once
 
+#include "opengl/types.hpp"
+
 #include <string>
 #include <unordered_map>
-
-#ifdef DEBUG
-#include <filesystem>
-#endif
+#include <vector>
 
 class ShaderManager {
   public:
@@ -16,16 +15,45 @@ class ShaderManager {
 	ShaderManager& operator=(const ShaderManager&) = delete;
 	~ShaderManager();
 
-	class Shader* get(const std::string& vert, const std::string& frag);
+	// Every set of defines is a separate permutation, compiled and cached on its own
+	class Shader* get(const std::string& vert, const std::string& frag,
+					  const ShaderDefines& defines = {});
 
-	void reload(bool full = false);
+	void reload();
+#ifdef DEBUG
+	void reload(const std::string& file);
+#endif
 
   private:
-	std::unordered_map<std::string, class Shader*> mTextures;
+	struct Permutation {
+		std::string vert;
+		std::string frag;
+		ShaderDefines defines;
+
+		class Shader* shader;
+	};
+
+	static std::string key(const std::string& vert, const std::string& frag,
+						   const ShaderDefines& defines);
+
+	// Returns the preprocessed source with the #version of the target
+	std::string source(const std::string& name, std::vector<std::string>& files) const;
+	class Shader* compile(const Permutation& permutation, const std::string& name);
+
+#ifdef DEBUG
+	void recompile(const std::string& name, Permutation& permutation);
+#endif
+
+#ifndef EMBED_SHADERS
+	void preprocess(const std::string& name, std::string& out, std::vector<std::string>& files) const;
+#endif
+
+	std::unordered_map<std::string, Permutation> mShaders;
 
 	std::string mPath;
 
 #ifdef DEBUG
-	std::unordered_map<class Shader*, std::filesystem::file_time_type> mLastEdit;
+	// Every file a shader was built from, includes too
+	std::unordered_map<std::string, std::vector<std::string>> mFiles;
 #endif
 };
@@ -3,10 +3,6 @@
 #include <string>
 #include <unordered_map>
 
-#ifdef DEBUG
-#include <filesystem>
-#endif
-
 class TextureManager {
   public:
 	explicit TextureManager(const std::string& path);
@@ -18,14 +14,13 @@ class TextureManager {
 
 	class Texture* get(const std::string& name);
 
-	void reload(bool full = false);
+	// Textures are reloaded in place, so the pointers handed out stay valid
+	void reload();
+	// Reloads the textures built from the file, relative to assets/textures
+	void reload(const std::string& file);
 
   private:
 	std::unordered_map<std::string, class Texture*> mTextures;
 
 	std::string mPath;
-
-#ifdef DEBUG
-	std::unordered_map<class Texture*, std::filesystem::file_time_type> mLastEdit;
-#endif
 };
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "third_party/glad/glad.h"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records the frames of a framebuffer without stalling the GPU
+// Every frame is read into a ring of pixel pack buffers and only mapped a few frames later, once
+// its fence signaled, the frames are converted and written to disk on a thread
+class Capture {
+  public:
+	enum Format {
+		// frameNNNNN.ppm for every frame
+		PPM,
+		// A single capture.y4m, 4:2:0 video most encoders and players take directly
+		Y4M,
+		// A single capture.rgb of packed top-down RGB frames, e.g. ffmpeg -f rawvideo
+		RAW,
+	};
+
+	// fps is only written to the Y4M header
+	Capture(const std::string& directory, Format format, unsigned int fps);
+	Capture(Capture&&) = delete;
+	Capture(const Capture&) = delete;
+	Capture& operator=(Capture&&) = delete;
+	Capture& operator=(const Capture&) = delete;
+	// Writes every frame still in flight
+	~Capture();
+
+	// Queues a read of the bottom left corner of the framebuffer, call after drawing to it
+	void capture(GLuint framebuffer, int width, int height);
+
+	// Parses ppm, y4m or raw
+	static bool parseFormat(const std::string& name, Format& format);
+
+	static constexpr unsigned int BUFFERS = 3;
+
+  private:
+	struct Frame {
+		int width;
+		int height;
+		// Bottom-up RGBA, as read
+		std::vector<unsigned char> pixels;
+	};
+
+	struct Slot {
+		GLuint buffer;
+		GLsizeiptr size;
+		GLsync fence;
+		int width;
+		int height;
+	};
+
+	// Waits for the GPU to be done with the slot, maps it and hands the frame to the writer
+	void read(Slot& slot);
+	void run();
+	void write(const Frame& frame);
+
+	std::string mDirectory;
+	Format mFormat;
+	unsigned int mFPS;
+
+	std::array<Slot, BUFFERS> mSlots;
+	unsigned int mNext;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<Frame> mFrames;
+	// Pixel storage of written frames, so that big frames aren't allocated every frame
+	std::vector<std::vector<unsigned char>> mFree;
+	bool mRunning;
+	std::thread mThread;
+
+	// Only touched by the writer thread
+	struct SDL_IOStream* mFile;
+	unsigned int mWritten;
+	int mStreamWidth, mStreamHeight;
+	std::vector<unsigned char> mConverted;
+};
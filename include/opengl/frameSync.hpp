@@ -0,0 +1,45 @@
+#pragma once
+
+#include "third_party/glad/glad.h"
+
+#include <array>
+#include <functional>
+#include <vector>
+
+// Keeps the CPU at most FRAMES frames ahead of the GPU with a fence at the end of every frame
+// Per frame resources (the regions of the ring buffer) are indexed by getFrame(), they are free to
+// write once begin() returns. Deleting GL objects is deferred until no frame in flight can use them
+class FrameSync {
+  public:
+	FrameSync() = delete;
+
+	static constexpr unsigned int FRAMES = 3;
+
+	// Waits until the GPU is done with the frame that last used this frame's resources and runs
+	// its deletes, this usually doesn't wait
+	static void begin();
+	// Fences everything submitted this frame, after the swap
+	static void end();
+	// Waits for every frame in flight and runs all deletes, before the context goes
+	static void finish();
+
+	// At most FRAMES, fewer trade throughput for latency since the CPU can't run as far ahead
+	static void setFramesInFlight(unsigned int frames);
+	[[nodiscard]] static unsigned int getFramesInFlight() { return mFramesInFlight; }
+
+	// Runs once the GPU is done with everything submitted so far, right away outside of frames
+	static void defer(std::function<void()> function);
+
+	[[nodiscard]] static unsigned int getFrame() { return mFrame; }
+
+  private:
+	static void wait(unsigned int frame);
+
+	static unsigned int mFrame;
+	static unsigned int mFramesInFlight;
+	// Between the first begin() and finish()
+	static bool mRunning;
+
+	static std::array<GLsync, FRAMES> mFences;
+	static std::array<std::vector<std::function<void()>>, FRAMES> mDeletes;
+};
@@ -1,9 +1,21 @@
 #pragma once
 
+#include "opengl/capture.hpp"
+#include "opengl/renderGraph.hpp"
+#include "third_party/Eigen/Dense"
 #include "third_party/glad/glad.h"
 
+#include <array>
 #include <memory>
+#include <string>
 
+// The scene is rendered offscreen and drawn to the window in swap
+// With dynamic resolution the scene only covers a part of the targets, scaled by the measured GPU
+// time against the budget, and is upscaled when drawn to the window
+// Drawing to the window goes through a reprojection, which maps the normalized device coordinates
+// of the window to the ones of the scene (homogeneous, identity when they are the same)
+// Post processing runs through a render graph in between, effects that are off cost nothing and
+// without any the scene is blitted straight to the window
 class Framebuffer {
   public:
 	explicit Framebuffer(class Game* owner);
@@ -14,14 +26,86 @@ class Framebuffer {
 	~Framebuffer();
 
 	void setDemensions(int width, int height);
-	void swap(struct SDL_Window* window);
+	// Binds the framebuffer with the viewport at the current scale and starts timing the frame
+	void begin();
+	// Ends the scene and presents it
+	void swap(struct SDL_Window* window, const Eigen::Matrix3f& reprojection);
+	// Draws the last scene to the window again, without anything new in it
+	void present(struct SDL_Window* window, const Eigen::Matrix3f& reprojection);
+
+	// Every frame is written until stopped, at full resolution
+	void startCapture(const std::string& directory, Capture::Format format, unsigned int fps);
+	void stopCapture();
+	[[nodiscard]] bool isCapturing() const { return mCapture != nullptr; }
+
+	// Milliseconds the scene may take on the GPU, usually the refresh interval
+	void setBudget(float budget) { mBudget = budget; }
+	[[nodiscard]] float getBudget() const { return mBudget; }
+	void setDynamic(bool dynamic);
+
+	[[nodiscard]] bool getDynamic() const { return mDynamic; }
+	[[nodiscard]] float getScale() const { return mScale; }
+	// Smoothed GPU time of the scene in milliseconds, 0 without timer queries
+	[[nodiscard]] float getGPUTime() const { return mGPUTime; }
+
+	// Each does nothing at its default
+	struct Effects {
+		// Radius of the blur in pixels
+		float blur = 0.0f;
+		float sharpen = 0.0f;
+		float exposure = 1.0f;
+		float vignette = 0.0f;
+	};
+	[[nodiscard]] Effects& getEffects() { return mEffects; }
+	[[nodiscard]] RenderGraph::Stats getPostStats() const { return mGraph->getStats(); }
+
+	static constexpr float MIN_SCALE = 0.5f;
 
   private:
+	// Size of the corner of the targets the scene is rendered to
+	[[nodiscard]] int sceneWidth() const;
+	[[nodiscard]] int sceneHeight() const;
+
+	// Declares the effects that are on and draws them
+	void postProcess();
+
+	// Reads back the finished queries without waiting on the GPU
+	void readQueries();
+	void updateScale(float time);
+
 	class Game* mOwner;
 
+	int mWidth, mHeight;
+
+	float mScale;
+	float mBudget;
+	float mGPUTime;
+	bool mDynamic;
+	// Frames left before the scale can change again, so that the new scale is measured first
+	unsigned int mCooldown;
+
+	// Results arrive a few frames late, so every frame gets its own query
+	static constexpr unsigned int QUERIES = 3;
+	std::array<GLuint, QUERIES> mQueries;
+	unsigned int mFirstQuery;
+	unsigned int mPendingQueries;
+	bool mTiming;
+
+	// GL 3.3, GLES only has it with GL_EXT_disjoint_timer_query
+	PFNGLGETQUERYOBJECTUI64VPROC mGetQueryObject;
+
 	GLuint mRBO;
 	GLuint mScreen;
 	GLuint mScreenTexture;
 
 	std::unique_ptr<class Mesh> mScreenMesh;
+
+	Effects mEffects;
+	std::unique_ptr<RenderGraph> mGraph;
+	// What the last post processing left to draw to the window
+	RenderGraph::Blit mBlit;
+
+	std::unique_ptr<Capture> mCapture;
+	// Restored when the capture stops
+	bool mCaptureDynamic;
 };
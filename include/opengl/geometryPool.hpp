@@ -0,0 +1,99 @@
+#pragma once
+
+#include "opengl/types.hpp"
+#include "third_party/Eigen/Core"
+#include "third_party/glad/glad.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Shared vertex and index buffers for every mesh with the Vertex layout,
+// so that a batch of meshes is a single multi draw indirect call
+// Needs base vertex and indirect draws, so only on desktop GL
+class GeometryPool {
+  public:
+	GeometryPool();
+	GeometryPool(GeometryPool&&) = delete;
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(GeometryPool&&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+	~GeometryPool();
+
+	// nullptr when meshes keep their own buffers
+	[[nodiscard]] static GeometryPool* get() { return mInstance; }
+
+	struct Allocation {
+		GLint baseVertex;
+		GLuint firstIndex;
+		GLsizei count;
+		GLsizei vertices;
+	};
+
+	Allocation allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+	void free(const Allocation& allocation);
+
+	void bind() const;
+
+	// Queue a draw of count instances of the allocation, with the model matrices at offset in
+	// the buffer. All the queued draws must share the state and the buffer, with the offsets
+	// increasing in steps of whole matrices
+	void add(const Allocation& allocation, GLuint buffer, GLintptr offset, GLsizei count);
+	// Submit the queued draws, once the program or textures change
+	void flush();
+
+	[[nodiscard]] bool multiDraw() const { return mMultiDraw != nullptr; }
+
+  private:
+	// Same layout as the GL indirect command
+	struct Command {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// First fit free list over a range of elements
+	class Allocator {
+	  public:
+		explicit Allocator(GLuint size) : mSize(size) { mFree[0] = size; }
+
+		// Returns false if there isn't a large enough range
+		bool allocate(GLuint size, GLuint& offset);
+		void free(GLuint offset, GLuint size);
+		void grow(GLuint size);
+
+		[[nodiscard]] GLuint size() const { return mSize; }
+
+	  private:
+		std::map<GLuint, GLuint> mFree;
+		GLuint mSize;
+	};
+
+	// Reallocates the buffer to the size in bytes, keeping the content
+	static void resize(GLuint& buffer, GLsizeiptr oldSize, GLsizeiptr newSize);
+	void setupAttributes() const;
+	void setInstanceOffset(GLintptr offset) const;
+
+	static GeometryPool* mInstance;
+
+	GLuint mVAO;
+	GLuint mVBO;
+	GLuint mEBO;
+	GLuint mIndirect;
+
+	Allocator mVertices;
+	Allocator mIndices;
+
+	std::vector<Command> mCommands;
+	// The base instances are relative to the first offset
+	std::vector<GLintptr> mOffsets;
+	GLuint mInstanceBuffer;
+	GLsizeiptr mIndirectCapacity;
+
+	// GL 4.3, glad only goes up to 4.0
+	typedef void(APIENTRYP MultiDrawProc)(GLenum mode, GLenum type, const void* indirect,
+										  GLsizei drawcount, GLsizei stride);
+	MultiDrawProc mMultiDraw;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "third_party/glad/glad.h"
+
+#include <array>
+#include <cstdint>
+
+// Shadows the bound GL state, so that binding what is already bound never reaches the driver
+// All engine code binds through here, code that bypasses it has to call reset()
+class GLState {
+  public:
+	GLState() = delete;
+
+	// Forget everything, the next call of every kind goes through
+	static void reset();
+
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vao);
+	static void bindFramebuffer(GLuint framebuffer);
+	// Binds to the unit, switching the active unit only if needed
+	static void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+	// Binds to the active unit, for uploads
+	static void bindTexture(GLenum target, GLuint texture);
+
+	static void enable(GLenum capability);
+	static void disable(GLenum capability);
+	static void depthFunc(GLenum func);
+	static void cullFace(GLenum face);
+	static void blendFunc(GLenum source, GLenum destination);
+	// Does nothing on GLES
+	static void polygonMode(GLenum mode);
+
+	// The object names get reused by the driver, the objects are deleted once no frame in flight
+	// uses them anymore
+	static void deleteProgram(GLuint program);
+	static void deleteVertexArray(GLuint vao);
+	static void deleteFramebuffer(GLuint framebuffer);
+	static void deleteTexture(GLuint texture);
+
+	struct Stats {
+		uint32_t calls;
+		uint32_t elided;
+	};
+
+	// Returns the stats of the last frame and starts counting the next one
+	static Stats frame();
+	[[nodiscard]] static Stats getStats() { return mLastFrame; }
+
+  private:
+	static constexpr GLuint UNKNOWN = ~0u;
+	static constexpr unsigned int UNITS = 32;
+	// 2D and cubemap
+	static constexpr unsigned int TARGETS = 2;
+
+	// Capabilities we track, in the order of the bits
+	static constexpr std::array<GLenum, 4> CAPABILITIES = {GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND,
+														   GL_STENCIL_TEST};
+
+	static bool changed(bool different);
+	static void setCapability(GLenum capability, bool enabled);
+
+	static GLuint mProgram;
+	static GLuint mVertexArray;
+	static GLuint mFramebuffer;
+
+	static unsigned int mActiveUnit;
+	static std::array<std::array<GLuint, TARGETS>, UNITS> mTextures;
+
+	static uint32_t mEnabled;
+	static uint32_t mKnown;
+	static GLenum mDepthFunc;
+	static GLenum mCullFace;
+	static GLenum mBlendSource;
+	static GLenum mBlendDestination;
+	static GLenum mPolygonMode;
+
+	static Stats mStats;
+	static Stats mLastFrame;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "third_party/glad/glad.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Times passes on the GPU with timestamp queries, passes can nest
+// Every frame in flight records into its own queries, which are read back when the frame comes
+// around again, so the CPU never waits on them. Frames that still aren't done by then are dropped
+class GPUProfiler {
+  public:
+	GPUProfiler();
+	GPUProfiler(GPUProfiler&&) = delete;
+	GPUProfiler(const GPUProfiler&) = delete;
+	GPUProfiler& operator=(GPUProfiler&&) = delete;
+	GPUProfiler& operator=(const GPUProfiler&) = delete;
+	~GPUProfiler();
+
+	static constexpr unsigned int FRAMES = 3;
+	static constexpr unsigned int HISTORY = 120;
+
+	// nullptr while there is no renderer
+	[[nodiscard]] static GPUProfiler* get() { return mInstance; }
+
+	void begin(const std::string_view& name);
+	void end();
+	// Reads back the oldest frame in flight and starts recording the next one
+	void frame();
+
+	struct Pass {
+		std::string name;
+		unsigned int depth;
+		// Milliseconds, smoothed over the last frames
+		float time;
+	};
+
+	// In the order of the last frame that was read back, passes of the same name and depth summed
+	[[nodiscard]] const std::vector<Pass>& getPasses() const { return mPasses; }
+	// Milliseconds of the top level passes of the last frames, starting at getHistoryOffset
+	[[nodiscard]] const std::array<float, HISTORY>& getHistory() const { return mHistory; }
+	[[nodiscard]] unsigned int getHistoryOffset() const { return mHistoryOffset; }
+	// GLES needs GL_EXT_disjoint_timer_query
+	[[nodiscard]] bool isSupported() const { return mQueryCounter != nullptr; }
+
+	// Logs the average of every pass since the last log
+	void log();
+
+	// Times the pass until the end of the scope
+	class Scope {
+	  public:
+		explicit Scope(const std::string_view& name) {
+			if (mInstance != nullptr) {
+				mInstance->begin(name);
+			}
+		}
+		Scope(Scope&&) = delete;
+		Scope(const Scope&) = delete;
+		Scope& operator=(Scope&&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		~Scope() {
+			if (mInstance != nullptr) {
+				mInstance->end();
+			}
+		}
+	};
+
+  private:
+	struct Marker {
+		std::string name;
+		unsigned int depth;
+		GLuint start;
+		GLuint end;
+	};
+
+	struct Frame {
+		std::vector<Marker> markers;
+		// Markers that haven't ended yet
+		std::vector<size_t> open;
+
+		// Grows to the most queries a frame used
+		std::vector<GLuint> queries;
+		size_t used;
+	};
+
+	GLuint query(Frame& frame);
+	void read(Frame& frame);
+
+	static GPUProfiler* mInstance;
+
+	std::array<Frame, FRAMES> mFrames;
+	unsigned int mFrame;
+
+	std::vector<Pass> mPasses;
+	std::array<float, HISTORY> mHistory;
+	unsigned int mHistoryOffset;
+
+	// Milliseconds and frames of every pass since the last log, in the order they first appeared
+	struct Total {
+		std::string name;
+		double time;
+		unsigned int frames;
+	};
+	std::vector<Total> mTotals;
+	// Frames read back since the last log
+	unsigned int mRead;
+
+	// GL 3.3, GLES only has them with GL_EXT_disjoint_timer_query
+	PFNGLQUERYCOUNTERPROC mQueryCounter;
+	PFNGLGETQUERYOBJECTUI64VPROC mGetQueryObject;
+};
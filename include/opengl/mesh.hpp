@@ -1,6 +1,8 @@
 #pragma once
 
+#include "opengl/geometryPool.hpp"
 #include "opengl/types.hpp"
+#include "third_party/Eigen/Geometry"
 #include "third_party/glad/glad.h"
 
 #include <utility>
@@ -16,16 +18,46 @@ class Mesh {
 	Mesh& operator=(const Mesh&) = delete;
 	~Mesh();
 
-	void draw(const class Shader* shader) const;
+	// Binding is split from drawing, so the renderer only rebinds when the state changes
+	void bindTextures(const class Shader* shader) const;
+	void bind() const;
+	void draw() const;
+	// One draw call for count instances, with the model matrices at offset in the buffer
+	// The mesh has to be bound, pooled meshes are drawn by adding them to the pool instead
+	void drawInstanced(GLuint buffer, GLintptr offset, GLsizei count) const;
+
+	// Suballocated from the geometry pool instead of having its own buffers
+	bool isPooled() const { return mPooled; }
+	const GeometryPool::Allocation& getAllocation() const { return mAllocation; }
 
 	unsigned int indices() const { return mIndices.size(); }
 	unsigned int vertices() const { return mVertices.size(); }
+	// Kept on the CPU, the occlusion culler rasterizes them
+	const std::vector<struct Vertex>& getVertexData() const { return mVertices; }
+	const std::vector<unsigned int>& getIndexData() const { return mIndices; }
 
-	void addTexture(std::pair<class Texture*, TextureType> texture) {
-		mTextures.emplace_back(texture);
+	// Sort key parts, equal materials have the same texture set
+	unsigned int getID() const { return mID; }
+	unsigned int getMaterial() const { return mMaterial; }
+	const std::vector<std::pair<class Texture*, TextureType>>& getTextures() const {
+		return mTextures;
 	}
 
+	void addTexture(std::pair<class Texture*, TextureType> texture);
+
+	// Object space bounds of the vertices
+	const Eigen::AlignedBox3f& getBounds() const { return mBounds; }
+
   private:
+	void updateMaterial();
+
+	unsigned int mID;
+	unsigned int mMaterial;
+	Eigen::AlignedBox3f mBounds;
+
+	bool mPooled;
+	GeometryPool::Allocation mAllocation;
+
 	GLuint mVBO;
 	GLuint mEBO;
 	GLuint mVAO;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "third_party/Eigen/Geometry"
+
+#include <array>
+#include <vector>
+
+// Software occlusion culling. The drawables marked as occluders, like walls, are rasterized on the
+// CPU into a small depth buffer, and the bounds of the packets are tested against a hierarchy of
+// its farthest depths, so what is hidden behind them never reaches the driver
+// The depth is 1 / w, which is linear over the screen, larger closer and 0 infinitely far
+// A pixel is covered when its center is, like on the GPU. Anything seen only through gaps
+// thinner than a pixel of the buffer can be culled
+class OcclusionCuller {
+  public:
+	OcclusionCuller();
+	OcclusionCuller(OcclusionCuller&&) = delete;
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+	~OcclusionCuller() = default;
+
+	static constexpr int WIDTH = 256;
+	static constexpr int HEIGHT = 128;
+	// Down to a single row
+	static constexpr int LEVELS = 8;
+
+	// Starts over with the camera of the frame, the triangles are clipped to the near plane like
+	// on the GPU
+	void begin(const Eigen::Matrix4f& viewProjection, float near);
+	// Only the front faces are drawn, the back faces are culled on the GPU too
+	void add(const class Mesh& mesh, const Eigen::Affine3f& model);
+	// Rasterizes the added triangles in bands of rows on the workers and builds the hierarchy
+	void rasterize(class ThreadPool& workers);
+
+	// True when the world space box, as center and half extent, is behind the occluders
+	// everywhere it covers. Only reads, so the lanes test in parallel
+	[[nodiscard]] bool occluded(const Eigen::Vector3f& center, const Eigen::Vector3f& extent) const;
+
+	struct Stats {
+		unsigned int occluders;
+		// Front facing and on the screen, after clipping
+		unsigned int triangles;
+	};
+	[[nodiscard]] Stats getStats() const { return mStats; }
+
+  private:
+	// The edge functions and the depth as planes over the screen, x * a + y * b + c. The edges
+	// are positive inside
+	struct Triangle {
+		std::array<Eigen::Vector3f, 3> edges;
+		Eigen::Vector3f depth;
+		int minX, maxX;
+		int minY, maxY;
+	};
+
+	// To screen x, y and depth, in front of the near plane
+	static Eigen::Vector3f project(const Eigen::Vector4f& clip);
+	// Adds the screen space triangle when it is front facing and covers a pixel center
+	void setup(const Eigen::Vector3f& v0, const Eigen::Vector3f& v1, const Eigen::Vector3f& v2);
+	// Draws the rows of the triangle in [begin, end)
+	void draw(const Triangle& triangle, int begin, int end);
+
+	Eigen::Matrix4f mViewProjection;
+	float mNear;
+
+	std::vector<Triangle> mTriangles;
+	// Clip space vertices of the mesh being added
+	std::vector<Eigen::Vector4f> mClip;
+
+	// Screen x of the pixel centers, to evaluate the planes along a row
+	Eigen::ArrayXf mColumns;
+	// Row major, level 0 is the depth buffer and every level after holds the farthest of 2x2
+	// of the one before
+	std::array<Eigen::ArrayXf, LEVELS> mLevels;
+
+	Stats mStats;
+};
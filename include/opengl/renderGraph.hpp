@@ -0,0 +1,103 @@
+#pragma once
+
+#include "opengl/types.hpp"
+#include "third_party/glad/glad.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Full screen post processing between the scene and the window, declared again every frame
+// Passes name their inputs and output. Executing culls the passes the output doesn't depend on,
+// merges the per pixel passes at the end into the final blit and takes the targets from a pool,
+// where a target is reused as soon as the last pass reading it is done
+// The targets are window sized with the content in the scaled corner, the same as the scene
+class RenderGraph {
+  public:
+	// Passes are drawn with the quad and framebuffer.vert
+	explicit RenderGraph(class Game* owner, const class Mesh* quad);
+	RenderGraph(RenderGraph&&) = delete;
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(RenderGraph&&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+	~RenderGraph();
+
+	using Resource = unsigned int;
+	// The scene color, imported every frame
+	static constexpr Resource SCENE = 0;
+
+	struct Pass {
+		const char* name;
+		// Bound to the units in order, the first as screen, the others as screen1, screen2...
+		std::vector<Resource> inputs;
+		Resource output;
+		// Fragment shader drawn over the output
+		std::string shader;
+		// Define of framebuffer.frag the pass is when it can be merged into the final blit, the
+		// shader has to be framebuffer.frag then. Empty for passes that read neighbouring pixels
+		std::string merge;
+		// Sets the uniforms of the shader, the final blit's when merged
+		std::function<void(const class Shader*)> uniforms;
+	};
+
+	// Starts declaring a frame, the scene is in the corner of the framebuffer at scale
+	void begin(GLuint framebuffer, GLuint texture, int width, int height, float scale);
+	[[nodiscard]] Resource create();
+	void addPass(Pass pass);
+
+	// What is left for the final blit
+	struct Blit {
+		GLuint framebuffer;
+		GLuint texture;
+		// One for every merged pass, in the order of the passes
+		ShaderDefines defines;
+		std::vector<std::function<void(const class Shader*)>> uniforms;
+	};
+
+	// Draws the passes the output depends on, the returned target stays untouched until the next
+	// frame is executed
+	Blit execute(Resource output);
+
+	struct Stats {
+		unsigned int declared;
+		unsigned int culled;
+		unsigned int merged;
+		// In the pool, the ones of the last frame are reused by the next
+		unsigned int targets;
+	};
+	[[nodiscard]] Stats getStats() const { return mStats; }
+
+  private:
+	struct Target {
+		GLuint framebuffer;
+		GLuint texture;
+		int width;
+		int height;
+		bool used;
+		// Frames since the target was last used, it is deleted after a while
+		unsigned int idle;
+	};
+
+	// Index of a free target, a new one when none is free
+	size_t acquire();
+	void destroy(const Target& target) const;
+	[[nodiscard]] GLuint getTexture(Resource resource) const;
+
+	class Game* mOwner;
+	const class Mesh* mQuad;
+
+	int mWidth, mHeight;
+	float mScale;
+	GLuint mSceneFramebuffer;
+	GLuint mSceneTexture;
+
+	std::vector<Pass> mPasses;
+	// Target of every resource, none until it is written
+	std::vector<size_t> mAssigned;
+	std::vector<Target> mTargets;
+	// Target of the last blit, held until the next frame
+	size_t mHeld;
+
+	Stats mStats;
+};
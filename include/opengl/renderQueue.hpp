@@ -0,0 +1,93 @@
+#pragma once
+
+#include "third_party/Eigen/Geometry"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A single draw call, the key orders the packets so that the state only changes at its boundaries
+struct DrawPacket {
+	uint64_t key;
+
+	class Shader* shader;
+	const class Mesh* mesh;
+	Eigen::Affine3f model;
+};
+
+// Packets are recorded by the drawables every frame, culled against the frustum and radix sorted by key
+// Key layout, from the most significant bit:
+//   layer (16 bits) | program (12 bits) | material (12 bits) | mesh (12 bits) | depth (12 bits)
+// Nothing in here touches GL, so the drawables record into lanes on the worker threads and only
+// the sorted packets are replayed on the thread of the context
+class RenderQueue {
+  public:
+	// The packets of a part of the drawables, only ever pushed to by one thread at a time
+	class Lane {
+	  public:
+		Lane();
+
+		// Packets that aren't cullable are always drawn, like the sky which follows the camera
+		void push(int layer, class Shader* shader, const class Mesh* mesh,
+				  const Eigen::Affine3f& model, bool cullable = true);
+
+	  private:
+		friend class RenderQueue;
+
+		void clear(const Eigen::Vector3f& eye, float far);
+		void cull(const Eigen::Matrix4f& viewProjection, const class OcclusionCuller* occlusion);
+
+		std::vector<DrawPacket> mPackets;
+
+		// World space bounds of the packets as structure of arrays, so the plane tests vectorize:
+		// center x, y, z and half extent x, y, z
+		std::array<std::vector<float>, 6> mBounds;
+		Eigen::ArrayXf mMargin;
+		unsigned int mCulled;
+		unsigned int mOccluded;
+
+		Eigen::Vector3f mEye;
+		float mFar;
+	};
+
+	explicit RenderQueue(class ThreadPool& workers);
+	RenderQueue(RenderQueue&&) = delete;
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(RenderQueue&&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+	~RenderQueue() = default;
+
+	// The depth of the packets is the distance to the eye, quantized up to far
+	void clear(const Eigen::Vector3f& eye, float far, size_t lanes = 1);
+	[[nodiscard]] Lane& getLane(size_t lane) { return mLanes[lane]; }
+	[[nodiscard]] size_t getLanes() const { return mLanes.size(); }
+
+	// Drops the packets whose bounds are fully outside of the frustum of the view projection, and
+	// then the ones behind the occluders when given, the lanes in parallel
+	void cull(const Eigen::Matrix4f& viewProjection,
+			  const class OcclusionCuller* occlusion = nullptr);
+	// Joins the lanes in their order and sorts, the same result however the lanes were recorded
+	void sort();
+
+	[[nodiscard]] const std::vector<DrawPacket>& packets() const { return mPackets; }
+	[[nodiscard]] unsigned int getCulled() const { return mCulled; }
+	[[nodiscard]] unsigned int getOccluded() const { return mOccluded; }
+
+	static uint64_t key(int layer, unsigned int program, unsigned int material, unsigned int mesh,
+						float depth);
+
+  private:
+	class ThreadPool& mWorkers;
+
+	std::vector<Lane> mLanes;
+	std::vector<DrawPacket> mPackets;
+
+	// Sorting moves the 8 byte keys with an index instead of the whole packets
+	std::vector<std::pair<uint64_t, uint32_t>> mKeys;
+	std::vector<std::pair<uint64_t, uint32_t>> mScratch;
+	std::vector<DrawPacket> mSorted;
+
+	unsigned int mCulled;
+	unsigned int mOccluded;
+};
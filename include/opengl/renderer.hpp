@@ -1,6 +1,12 @@
 #pragma once
 
+#include "third_party/Eigen/Dense"
+#include "third_party/glad/glad.h"
+
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
 class Renderer {
@@ -16,29 +22,116 @@ class Renderer {
 	[[nodiscard]] inline int getHeight() const { return mHeight; }
 
 	void setDemensions(int width, int height);
+	// False while the window is hidden, minimized or covered
+	[[nodiscard]] bool isVisible() const;
+
+	// Captures every frame into the directory, in the format of the command line
+	void startCapture(const std::string& directory) const;
 	void setCamera(class CameraComponent* camera) { mCamera = camera; }
+	[[nodiscard]] class CameraComponent* getCamera() const { return mCamera; }
+
+	// Keeps a single frame in flight and turns the camera right before the frame is written,
+	// instead of when the actors update. Less throughput for less input latency
+	void setLowLatency(bool lowLatency);
+	[[nodiscard]] bool isLowLatency() const { return mLowLatency; }
+
+	// Draws the scene only every interval refreshes, with a wider field of view. The refreshes in
+	// between turn the last scene to where the camera looks now, which keeps looking around at the
+	// display rate. An interval of 0 picks it by the GPU time of the scene
+	void setReprojection(bool reproject, unsigned int interval);
+	[[nodiscard]] bool isReprojecting() const { return mReproject; }
+	[[nodiscard]] unsigned int getInterval() const { return mInterval; }
+	// False when the last frame only reprojected
+	[[nodiscard]] bool drewScene() const { return mSinceScene == 0; }
+	static constexpr unsigned int MAX_INTERVAL = 4;
+
+	// Culls what is hidden behind the drawables marked as occluders too
+	void setOcclusion(bool occlude) { mOcclude = occlude; }
+	[[nodiscard]] bool isOccluding() const { return mOcclude; }
+	[[nodiscard]] const class OcclusionCuller& getOcclusion() const { return *mOcclusion; }
 
+	[[nodiscard]] const class RenderQueue& getQueue() const { return *mQueue; }
+	[[nodiscard]] class ThreadPool& getWorkers() const { return *mWorkers; }
+	[[nodiscard]] class Framebuffer* getFramebuffer() const { return mFramebuffer.get(); }
+
+	// Drawables and lights are only made on the thread of the context, drawables make GL objects
+	// and the lights are read by the snapshot. Throws on any other thread, like the update thread
 	void addSprite(class DrawComponent* sprite);
 	void removeSprite(class DrawComponent* sprite);
-	// TODO: Add lights
-	// void addLight(class Actor* source);
+	void addLight(class LightComponent* light);
+	void removeLight(class LightComponent* light);
+	[[nodiscard]] class LightManager* getLights() const { return mLights.get(); }
 
-	void draw() const;
+	// Takes everything the next frame draws from the actors: the camera, the packets of the
+	// drawables and the lights. Drawing only reads what was taken, so the actors can be updated
+	// while the frame is submitted
+	void snapshot();
+	// Draws the last snapshot, in low latency mode one taken right after latching the camera
+	void draw();
 	void reload() const;
+	// Reimports the models in the directory of the file, which could be a material or texture
+	void reloadModel(const std::string& file) const;
 
   private:
-	void setLights(class Shader* shader) const;
+	// Camera and lights, read by every shader through the Frame block
+	void setFrame(struct FrameData& frame) const;
+	void checkThread() const;
+	void snapshotCamera();
+
+	// Counts the refreshes, false while the last scene can be reprojected
+	bool sceneDue();
+	// Reprojects the last scene to the camera and swaps
+	void present();
+	// From the normalized device coordinates of the camera to the ones of the last scene
+	[[nodiscard]] Eigen::Matrix3f reprojection() const;
 
 	class Game* mOwner;
+	// The one the context is current on
+	std::thread::id mThread;
 
 	struct SDL_Window* mWindow;
 	std::unique_ptr<class GLManager> mGL;
+	// Needs the context, so it is destroyed before it
+	std::unique_ptr<class GPUProfiler> mProfiler;
+	// Declared before everything that has meshes, so it outlives them
+	std::unique_ptr<class GeometryPool> mPool;
 	std::unique_ptr<class Framebuffer> mFramebuffer;
 
 	std::vector<class DrawComponent*> mDrawables;
+	// Record the drawables and write their models, the queue is replayed on this thread
+	std::unique_ptr<class ThreadPool> mWorkers;
+	std::unique_ptr<class RenderQueue> mQueue;
+	std::unique_ptr<class OcclusionCuller> mOcclusion;
+	bool mOcclude;
+	std::unique_ptr<class RingBuffer> mRing;
+	GLint mUniformAlignment;
+	std::unique_ptr<class LightManager> mLights;
+
+	// Packets of the same program and mesh, drawn with their models at offset in the ring buffer
+	struct Run {
+		size_t first;
+		size_t count;
+		GLintptr offset;
+	};
+	std::vector<Run> mRuns;
 	std::vector<class Cubemap*> mCubemaps;
 
 	int mWidth, mHeight;
+	unsigned int mRefreshRate;
+	bool mLowLatency;
+
+	bool mReproject;
+	unsigned int mInterval;
+	unsigned int mSinceScene;
+	// Rotation of the view and the scale of the projection the last scene was drawn with
+	Eigen::Matrix3f mSceneRotation;
+	Eigen::Vector2f mSceneScale;
+
+	// Camera of the last snapshot, the scene projection is wider while reprojecting
+	Eigen::Affine3f mView;
+	Eigen::Matrix4f mProjection;
+	Eigen::Matrix4f mSceneProjection;
+	Eigen::Vector3f mEye;
 
 	class CameraComponent* mCamera;
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "opengl/frameSync.hpp"
+#include "third_party/glad/glad.h"
+
+#include <vector>
+
+// A buffer split into a region per frame in flight, written linearly every frame
+// Persistently mapped when buffer storage is available (GL 4.4), otherwise the region of the
+// frame is mapped unsynchronized between begin and commit. Where that can't be mapped, like on
+// WebGL, it is written to memory and uploaded in commit
+// The region of a frame is the one of FrameSync::getFrame(), its fence keeps us from writing into a
+// region the GPU is still reading from
+class RingBuffer {
+  public:
+	// size is the size of a single frame's region
+	explicit RingBuffer(GLsizeiptr size);
+	RingBuffer(RingBuffer&&) = delete;
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(RingBuffer&&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+	~RingBuffer();
+
+	// After FrameSync::begin(), the GPU is done with the region by then
+	void begin();
+	// Returns where to write and sets the offset to bind at, nullptr if the region is full
+	// A full region grows for the next frames, up to MAX_SIZE
+	void* allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset);
+	// Everything has to be written before the GPU uses the buffer
+	void commit();
+
+	[[nodiscard]] GLuint getBuffer() const { return mBuffer; }
+	[[nodiscard]] bool isPersistent() const { return mBufferStorage != nullptr; }
+
+	static constexpr unsigned int FRAMES = FrameSync::FRAMES;
+	// Largest region, what doesn't fit is dropped instead of growing without end
+	static constexpr GLsizeiptr MAX_SIZE = 64 << 20;
+
+  private:
+	void create();
+	void release();
+
+	GLuint mBuffer;
+	GLsizeiptr mSize;
+	GLsizeiptr mOffset;
+	unsigned int mFrame;
+	bool mGrow;
+
+	// The whole buffer when persistent, otherwise only the region between begin and commit
+	char* mMapped;
+	// Written instead of a mapping when the region couldn't be mapped, and uploaded in commit
+	std::vector<char> mStaging;
+	bool mStaged;
+
+	// GL 4.4, glad only goes up to 4.0
+	typedef void(APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data,
+											  GLbitfield flags);
+	BufferStorageProc mBufferStorage;
+};
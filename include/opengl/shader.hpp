@@ -3,18 +3,36 @@
 #include "third_party/Eigen/Dense"
 #include "third_party/glad/glad.h"
 
+#include <functional>
+#include <map>
+#include <string>
 #include <string_view>
 
 class Shader {
   public:
-	explicit Shader(const std::string_view& vertName, const std::string_view& fragName);
+	// Takes the preprocessed sources, the names are only used for logging and profiling
+	// The defines are inserted after the #version line of both stages
+	explicit Shader(const std::string_view& vertName, const std::string_view& vertSource,
+					const std::string_view& fragName, const std::string_view& fragSource,
+					const std::string_view& defines = "");
 	Shader(Shader&&) = delete;
 	Shader(const Shader&) = delete;
 	Shader& operator=(Shader&&) = delete;
 	Shader& operator=(const Shader&) = delete;
 	~Shader();
 
+	// Uniform buffer binding of the Frame block in frame.glsl
+	static constexpr GLuint FRAME_BINDING = 0;
+	// Of the Lights block in lighting.glsl, and the units of its cluster textures above the ones
+	// of the materials
+	static constexpr GLuint LIGHTS_BINDING = 1;
+	static constexpr GLint LIGHT_GRID_UNIT = 14;
+	static constexpr GLint LIGHT_INDEX_UNIT = 15;
+
 	void activate() const;
+	[[nodiscard]] GLuint getID() const { return mShaderProgram; }
+	// Name of the fragment shader
+	[[nodiscard]] const std::string& getName() const { return mName; }
 
 	// set uniform
 	void set(const std::string_view& name, const GLboolean& val) const;
@@ -28,14 +46,20 @@ class Shader {
 	void set(const std::string_view& name, const Eigen::Vector3f& val) const;
 	void set(const std::string_view& name, const Eigen::Vector3f& val, const GLfloat& val2) const;
 	void set(const std::string_view& name, const Eigen::Vector4f& val) const;
+	void set(const std::string_view& name, const Eigen::Matrix3f& mat) const;
 	// Note: Eigen uses column major storage as default, so no transpose
 	void set(const std::string_view& name, const Eigen::Affine3f& mat,
 			 const GLboolean& transpose = GL_FALSE) const;
 
   private:
-	static void compile(const std::string_view& fileName, const GLenum& type, GLuint& out);
+	static void compile(const std::string_view& name, const std::string_view& source,
+						const std::string_view& defines, const GLenum& type, GLuint& out);
 
 	void setUniform(const std::string_view& name, std::function<void(GLint)> toCall) const;
 
 	GLuint mShaderProgram;
+	std::string mName;
+	// Looked up once after linking, asking the driver on every set can stall multithreaded drivers
+	// Arrays are there by their base name and every element
+	std::map<std::string, GLint, std::less<>> mLocations;
 };
@@ -15,6 +15,10 @@ class Texture {
 
 	virtual void activate(const unsigned int& num) const;
 	virtual void load();
+	// Loads it again into the same object, the old texture is only freed once that succeeded
+	void reload();
+
+	[[nodiscard]] const std::string& getPath() const { return name; }
 
   protected:
 	GLuint mID;
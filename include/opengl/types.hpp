@@ -2,6 +2,9 @@
 
 #include "third_party/Eigen/Core"
 
+#include <map>
+#include <string>
+
 struct Vertex {
 	Eigen::Vector3f position;
 	Eigen::Vector3f normal;
@@ -9,3 +12,6 @@ struct Vertex {
 };
 
 typedef enum TextueType { DIFFUSE, SPECULAR, HEIGHT, AMBIENT } TextureType;
+
+// Preprocessor defines of a shader permutation, name -> value (empty for a plain #define)
+typedef std::map<std::string, std::string> ShaderDefines;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "opengl/capture.hpp"
+
+#include <optional>
+#include <string>
+
+// Command line: ./Panorama [--size WxH] [--frames N] [--output directory] [--format ppm|y4m|raw]
+//                         [--trace file] [--benchmark report] [--path file] [--record file]
+//                         [--low-latency delay] [--reproject interval] [--threads N] file
+struct Options {
+	std::string pano;
+
+	int width = 1024;
+	int height = 768;
+
+	// Quit after drawing this many frames, 0 runs until quit
+	unsigned int frames = 0;
+	// Directory every drawn frame is captured to, nothing is captured when empty
+	// Also where F4 captures to, when given
+	std::string output;
+	Capture::Format format = Capture::PPM;
+
+	// Chrome trace of the CPU scopes written on quit, only recorded in PROFILE builds
+	std::string trace;
+
+	// JSON report of a benchmark run, an interactive run when empty
+	// Benchmarks go along the path once unless the frames are given
+	std::string benchmark;
+	// Camera path the benchmark follows, an orbit when empty
+	std::string path;
+	// Where F6 records the camera path to, when given. Never the path read, so recording during a
+	// benchmark can't overwrite it
+	std::string record;
+
+	// Samples the camera right before drawing with a single frame in flight
+	bool lowLatency = false;
+	// Milliseconds every frame starts late in low latency mode, so that input is sampled closer to
+	// the next refresh. Too long and frames miss it
+	unsigned int delay = 0;
+
+	// Draws the scene every interval refreshes and reprojects it to the camera in between, 0 picks
+	// the interval by the GPU time of the scene
+	bool reproject = false;
+	unsigned int interval = 0;
+
+	// Threads recording and culling the drawables, the main thread included. 0 uses every core
+	// With more than one, the actors also update on their own thread while the frame is drawn
+	unsigned int threads = 0;
+
+	// Logs the usage and returns nothing on malformed arguments
+	static std::optional<Options> parse(int argc, char** argv);
+};
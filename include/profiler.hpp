@@ -0,0 +1,105 @@
+#pragma once
+
+// Scoped CPU timers, the macros compile to nothing unless built with PROFILE
+// PROFILE_SCOPE("name") times until the end of the scope, only the pointer to the name is stored,
+// so it has to be a literal
+
+#ifdef PROFILE
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#define PROFILE_SCOPE(name) const Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#define PROFILE_FRAME() Profiler::frame()
+
+// Every thread records into its own ring of the last events, the lock is only ever contended
+// while the rings are read
+class Profiler {
+  public:
+	Profiler() = delete;
+
+	static constexpr unsigned int CAPACITY = 1 << 14;
+
+	struct Event {
+		const char* name;
+		// Nanoseconds since the first event
+		uint64_t start;
+		uint64_t end;
+		unsigned int depth;
+	};
+
+	struct Thread {
+		std::string name;
+		unsigned int id;
+		// Ordered by end
+		std::vector<Event> events;
+	};
+
+	class Scope {
+	  public:
+		explicit Scope(const char* name) : mName(name), mStart(now()) { Profiler::push(); }
+		Scope(Scope&&) = delete;
+		Scope(const Scope&) = delete;
+		Scope& operator=(Scope&&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		~Scope() { Profiler::pop(mName, mStart); }
+
+	  private:
+		const char* mName;
+		uint64_t mStart;
+	};
+
+	static uint64_t now();
+
+	// Shown as the name of the calling thread in the traces
+	static void setThreadName(const char* name);
+
+	// Marks the end of a frame, called by the thread that draws
+	static void frame();
+	// Start and end of the last finished frame, both 0 before the second frame
+	static void getFrame(uint64_t& start, uint64_t& end);
+
+	// Copies the events of every thread that ended between start and end
+	static std::vector<Thread> collect(uint64_t start, uint64_t end);
+	// Writes everything still in the rings as Chrome trace JSON, for Perfetto or chrome://tracing
+	static bool write(const std::string& path);
+
+  private:
+	struct Buffer {
+		std::mutex mutex;
+		std::string name;
+		unsigned int id;
+
+		std::array<Event, CAPACITY> events;
+		// Events ever recorded, the ring holds the last CAPACITY
+		uint64_t count;
+		// Open scopes, only touched by the owning thread
+		unsigned int depth;
+	};
+
+	static Buffer& buffer();
+	// Created on the first event of the thread
+	static thread_local Buffer* mBuffer;
+
+	static void push();
+	static void pop(const char* name, uint64_t start);
+
+	// Buffers are never freed, so that the events of finished threads can still be written
+	static std::mutex mMutex;
+	static std::vector<Buffer*> mBuffers;
+
+	static uint64_t mFrameStart;
+	static uint64_t mLastFrameStart;
+	static uint64_t mLastFrameEnd;
+};
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#define PROFILE_FRAME()
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads for the data parallel parts of a frame, like recording and culling the drawables
+// The calling thread works too, so a pool without workers runs everything in place
+class ThreadPool {
+  public:
+	// Threads including the calling one, 0 uses every core
+	explicit ThreadPool(unsigned int threads = 0);
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	using Function = std::function<void(size_t chunk, size_t begin, size_t end)>;
+
+	// Splits [0, count) into chunks ranges and calls the function for every one of them on any of
+	// the threads, returns once all are done. The ranges only depend on the count and chunks, so
+	// output kept per chunk comes out the same no matter which thread ran it
+	// Only one thread may run at a time, and not from inside of a function
+	void run(size_t count, size_t chunks, const Function& function);
+
+	// Enough chunks for every thread to take a few, of at least grain items
+	[[nodiscard]] size_t chunks(size_t count, size_t grain) const;
+
+	// Workers and the calling thread
+	[[nodiscard]] unsigned int getThreads() const {
+		return static_cast<unsigned int>(mWorkers.size()) + 1;
+	}
+
+  private:
+	void work();
+	// Takes chunks until none are left
+	void help();
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mDone;
+	bool mRunning;
+	// Counts the runs, so that the workers notice a new one
+	uint64_t mGeneration;
+	// Workers inside of help
+	unsigned int mBusy;
+
+	// Written under the lock before the generation changes
+	const Function* mFunction;
+	size_t mCount;
+	size_t mChunks;
+	std::atomic<size_t> mNext;
+	std::atomic<size_t> mRemaining;
+};
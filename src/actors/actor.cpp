@@ -2,6 +2,7 @@
 
 #include "components/component.hpp"
 #include "game.hpp"
+#include "utils.hpp"
 
 #include <cstdint>
 #include <algorithm>
@@ -35,6 +36,31 @@ void Actor::updateComponents(float delta) {
 
 void Actor::updateActor(float delta) { (void)delta; }
 
+// Only actual changes redraw, components set the same transform every frame
+void Actor::setPosition(const Eigen::Vector3f& pos) {
+	if (!(pos - mPosition).isZero()) {
+		mGame->redraw();
+	}
+
+	mPosition = pos;
+}
+
+void Actor::setScale(float scale) {
+	if (!nearZero(scale - mScale)) {
+		mGame->redraw();
+	}
+
+	mScale = scale;
+}
+
+void Actor::setRotation(const Eigen::Quaternionf& rotation) {
+	if (!rotation.isApprox(mRotation)) {
+		mGame->redraw();
+	}
+
+	mRotation = rotation;
+}
+
 void Actor::input(const uint8_t* keystate) {
 	if (mState != ALIVE) {
 		return;
@@ -1,6 +1,7 @@
 #include "actors/player.hpp"
 
 #include "components/cameraComponent.hpp"
+#include "components/lightComponent.hpp"
 #include "components/movementComponent.hpp"
 #include "game.hpp"
 #include "third_party/Eigen/Geometry"
@@ -12,6 +13,10 @@ Player::Player(class Game* owner) : Actor(owner), up(0) {
 	new CameraComponent(this);
 	mMoveComp = new MovementComponent(this);
 
+	// Flashlight
+	LightComponent* const light = new LightComponent(this);
+	light->setSpot(12.5f, 15.0f);
+
 	setPosition(Eigen::Vector3f(0.0f, 1.0f, 3.0f));
 }
 
@@ -47,6 +52,11 @@ void Player::updateActor(float delta) {
 	pos.y() += up * delta;
 	setPosition(pos);
 
+	// Benchmarks move the camera along their path
+	if (getGame()->getBenchmark() != nullptr) {
+		return;
+	}
+
 	auto rot = getRotation();
 
 	setRotation(rot * Eigen::AngleAxisf(-delta / 2, Eigen::Vector3f::UnitY()));
@@ -12,6 +12,7 @@ World::World(class Game* owner, std::string pano) : Actor(owner) {
 		new ModelComponent(this, getGame()->fullPath("models" SEPARATOR "backpack.obj"));
 	model->setVert("common.vert");
 	model->setFrag("backpack.frag");
+	model->setDefine("CUBE_REFRACT");
 	model->addTexture(std::make_pair(this->getGame()->getTexture("panorama"),
 	TextureType::DIFFUSE));
 
@@ -63,5 +64,6 @@ World::World(class Game* owner, std::string pano) : Actor(owner) {
 	MeshComponent* const box = new MeshComponent(this, verticesBox, indicesBox, texturesBox, 200);
 	box->setVert("sky.vert");
 	box->setFrag("sky.frag");
+	box->setCullable(false);
 }
 
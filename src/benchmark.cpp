@@ -0,0 +1,151 @@
+#include "benchmark.hpp"
+
+#include "actors/actor.hpp"
+#include "cameraPath.hpp"
+#include "components/cameraComponent.hpp"
+#include "game.hpp"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Kilobytes, 0 where the platform doesn't tell
+static long peakMemory() {
+#if defined(__linux__) || defined(__APPLE__)
+	rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+
+#ifdef __APPLE__
+	// Bytes on macOS
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#else
+	return 0;
+#endif
+}
+
+// Nearest rank of the sorted times
+static float percentile(const std::vector<float>& sorted, float percent) {
+	if (sorted.empty()) {
+		return 0.0f;
+	}
+
+	const size_t rank = static_cast<size_t>(std::ceil(percent / 100.0f * sorted.size()));
+
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static const char* glString(GLenum name) {
+	const GLubyte* string = glGetString(name);
+
+	return string == nullptr ? "" : reinterpret_cast<const char*>(string);
+}
+
+Benchmark::Benchmark(Game* game, std::unique_ptr<CameraPath> path, uint64_t start)
+	: mOwner(game), mPath(std::move(path)), mStart(start), mLoadTime(0.0f), mFirstFrame(0.0f),
+	  mLast(SDL_GetTicksNS()) {
+	mLoadTime = static_cast<float>(mLast - mStart) / 1000000.0f;
+
+	SDL_Log("Benchmarking %u frames, loading took %.1f ms", getFrames(), mLoadTime);
+}
+
+Benchmark::~Benchmark() = default;
+
+unsigned int Benchmark::getFrames() const {
+	return static_cast<unsigned int>(std::ceil(mPath->getDuration() / STEP)) + 1;
+}
+
+void Benchmark::update(CameraComponent* camera, unsigned int step) const {
+	const CameraPath::Key key = mPath->sample(static_cast<float>(step) * STEP);
+
+	camera->getOwner()->setPosition(key.position);
+	camera->getOwner()->setRotation(key.rotation);
+	camera->setFOV(key.fov);
+}
+
+void Benchmark::frame() {
+	const uint64_t now = SDL_GetTicksNS();
+
+	if (mFirstFrame <= 0.0f) {
+		mFirstFrame = static_cast<float>(now - mStart) / 1000000.0f;
+	} else {
+		mTimes.emplace_back(static_cast<float>(now - mLast) / 1000000.0f);
+	}
+
+	mLast = now;
+}
+
+bool Benchmark::report(const std::string& file) const {
+	// The first frame is timed from the start, it is in first_frame_ms
+	const size_t warmup = std::min<size_t>(WARMUP, mTimes.size());
+	std::vector<float> times(mTimes.begin() + static_cast<long>(warmup), mTimes.end());
+	std::sort(times.begin(), times.end());
+
+	double sum = 0.0;
+	for (const float time : times) {
+		sum += time;
+	}
+	const float mean = times.empty() ? 0.0f : static_cast<float>(sum / times.size());
+
+	const float p50 = percentile(times, 50.0f);
+	const float p95 = percentile(times, 95.0f);
+	const float p99 = percentile(times, 99.0f);
+	const float max = times.empty() ? 0.0f : times.back();
+	const long memory = peakMemory();
+
+	SDL_Log("Benchmark: %zu frames, %.3f ms mean, %.3f p50, %.3f p95, %.3f p99, %.3f max",
+			times.size(), mean, p50, p95, p99, max);
+	SDL_Log("Loading %.1f ms, first frame after %.1f ms, peak memory %ld KiB", mLoadTime,
+			mFirstFrame, memory);
+
+	std::string out;
+	char buffer[512];
+
+	std::snprintf(buffer, sizeof(buffer),
+				  "{\n"
+				  "  \"renderer\": \"%s\",\n"
+				  "  \"version\": \"%s\",\n"
+				  "  \"width\": %d,\n"
+				  "  \"height\": %d,\n"
+				  "  \"step_ms\": %.3f,\n"
+				  "  \"warmup\": %u,\n"
+				  "  \"frames\": %zu,\n",
+				  glString(GL_RENDERER), glString(GL_VERSION), mOwner->getWidth(),
+				  mOwner->getHeight(), STEP * 1000.0f, WARMUP, times.size());
+	out += buffer;
+
+	std::snprintf(buffer, sizeof(buffer),
+				  "  \"frame_ms\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, "
+				  "\"max\": %.3f},\n"
+				  "  \"load_ms\": %.1f,\n"
+				  "  \"first_frame_ms\": %.1f,\n"
+				  "  \"peak_memory_kb\": %ld\n"
+				  "}\n",
+				  mean, p50, p95, p99, max, mLoadTime, mFirstFrame, memory);
+	out += buffer;
+
+	if (!SDL_SaveFile(file.data(), out.data(), out.size())) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the benchmark report %s: %s\n",
+					 file.data(), SDL_GetError());
+
+		return false;
+	}
+
+	SDL_Log("Wrote the benchmark report to %s", file.data());
+
+	return true;
+}
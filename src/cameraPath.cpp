@@ -0,0 +1,130 @@
+#include "cameraPath.hpp"
+
+#include "third_party/Eigen/Geometry"
+#include "utils.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+static constexpr float ORBIT_DURATION = 20.0f;
+static constexpr unsigned int ORBIT_KEYS = 40;
+
+std::unique_ptr<CameraPath> CameraPath::orbit(const Eigen::Vector3f& position,
+											  const Eigen::Quaternionf& rotation, float fov) {
+	std::unique_ptr<CameraPath> path = std::make_unique<CameraPath>();
+
+	for (unsigned int i = 0; i <= ORBIT_KEYS; i++) {
+		const float progress = static_cast<float>(i) / ORBIT_KEYS;
+		const float angle = progress * 2.0f * PI;
+
+		// Down to half the field of view halfway through
+		const float zoom = 1.0f - 0.25f * (1.0f - std::cos(angle));
+
+		const Eigen::Quaternionf turn(Eigen::AngleAxisf(-angle, Eigen::Vector3f::UnitY()));
+
+		path->add({progress * ORBIT_DURATION, position, rotation * turn, fov * zoom});
+	}
+
+	return path;
+}
+
+std::unique_ptr<CameraPath> CameraPath::load(const std::string& file) {
+	char* data = static_cast<char*>(SDL_LoadFile(file.data(), nullptr));
+	if (data == nullptr) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read the camera path %s: %s\n",
+					 file.data(), SDL_GetError());
+
+		return nullptr;
+	}
+
+	const std::string text(data);
+	SDL_free(data);
+
+	std::unique_ptr<CameraPath> path = std::make_unique<CameraPath>();
+
+	size_t start = 0;
+	unsigned int number = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos) {
+			end = text.size();
+		}
+
+		const std::string line = text.substr(start, end - start);
+		start = end + 1;
+		number++;
+
+		if (line.empty() || line.starts_with('#')) {
+			continue;
+		}
+
+		Key key = {};
+		if (std::sscanf(line.data(), "%f %f %f %f %f %f %f %f %f", &key.time, &key.position.x(),
+						&key.position.y(), &key.position.z(), &key.rotation.w(), &key.rotation.x(),
+						&key.rotation.y(), &key.rotation.z(), &key.fov) != 9 ||
+			(!path->empty() && key.time < path->getDuration())) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Malformed key on line %u of %s\n", number,
+						 file.data());
+
+			return nullptr;
+		}
+
+		key.rotation.normalize();
+		path->add(key);
+	}
+
+	if (path->empty()) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "The camera path %s has no keys\n", file.data());
+
+		return nullptr;
+	}
+
+	return path;
+}
+
+bool CameraPath::save(const std::string& file) const {
+	std::string out = "# time x y z qw qx qy qz fov\n";
+
+	char line[256];
+	for (const Key& key : mKeys) {
+		std::snprintf(line, sizeof(line), "%.4f %.5f %.5f %.5f %.6f %.6f %.6f %.6f %.3f\n",
+					  key.time, key.position.x(), key.position.y(), key.position.z(),
+					  key.rotation.w(), key.rotation.x(), key.rotation.y(), key.rotation.z(),
+					  key.fov);
+		out += line;
+	}
+
+	if (!SDL_SaveFile(file.data(), out.data(), out.size())) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the camera path %s: %s\n",
+					 file.data(), SDL_GetError());
+
+		return false;
+	}
+
+	SDL_Log("Wrote %zu camera keys to %s", mKeys.size(), file.data());
+
+	return true;
+}
+
+CameraPath::Key CameraPath::sample(float time) const {
+	const auto next = std::upper_bound(mKeys.begin(), mKeys.end(), time,
+									   [](float t, const Key& key) { return t < key.time; });
+
+	if (next == mKeys.begin()) {
+		return mKeys.front();
+	}
+	if (next == mKeys.end()) {
+		return mKeys.back();
+	}
+
+	const Key& a = *(next - 1);
+	const Key& b = *next;
+	const float t = (time - a.time) / (b.time - a.time);
+
+	return {time, a.position + (b.position - a.position) * t, a.rotation.slerp(t, b.rotation),
+			a.fov + (b.fov - a.fov) * t};
+}
@@ -4,14 +4,25 @@
 #include "components/component.hpp"
 #include "game.hpp"
 #include "opengl/renderer.hpp"
+#include "profiler.hpp"
 #include "third_party/Eigen/Geometry"
 #include "utils.hpp"
 
 #include <SDL3/SDL.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+
+// Radians per second with the right stick all the way over, and the part of it that is ignored
+static constexpr float STICK_SPEED = 2.0f;
+static constexpr float STICK_DEADZONE = 0.15f;
+
+// The view the camera always had, it took 45 as radians before the field of view was in degrees
+static constexpr float DEFAULT_FOV = 58.31f;
 
 CameraComponent::CameraComponent(Actor* owner, int priority)
-	: Component(owner, priority), mFOV(45) {
+	: Component(owner, priority), mFOV(DEFAULT_FOV), mNear(0.1f), mFar(100.0f),
+	  mLooked(SDL_GetTicksNS()) {
 	mProjectionMatrix = Eigen::Affine3f::Identity();
 
 	Eigen::Quaternionf dir = mOwner->getRotation();
@@ -20,20 +31,66 @@ CameraComponent::CameraComponent(Actor* owner, int priority)
 	mOwner->getGame()->getRenderer()->setCamera(this);
 };
 
+void CameraComponent::input(const uint8_t* keystate) {
+	if (!mOwner->getGame()->getRenderer()->isLowLatency()) {
+		look();
+	}
+
+	(void)keystate;
+}
+
 void CameraComponent::update(float delta) {
+	project();
+	view();
+
+	(void)delta;
+}
+
+void CameraComponent::latch() {
+	PROFILE_SCOPE("CameraComponent::latch");
+
+	// The mouse and gamepad state only moves on when the events are pumped, they are still
+	// handled by the game on the next iteration
+	SDL_PumpEvents();
+
+	look();
+	view();
+}
+
+void CameraComponent::look() {
+	const uint64_t now = SDL_GetTicksNS();
+	const float delta = std::min(static_cast<float>(now - mLooked) / 1000000000.0f, 0.05f);
+	mLooked = now;
+
+	// Benchmarks move the camera along their path
+	if (mOwner->getGame()->getBenchmark() != nullptr) {
+		return;
+	}
+
 	float x = 0;
 	float y = 0;
 	SDL_GetRelativeMouseState(&x, &y);
+	x /= 50;
+	y /= 50;
 
-	const Eigen::Quaternionf dir = mOwner->getRotation();
-	const Eigen::AngleAxisf rot(-(x / 50) * delta, Eigen::Vector3f::UnitY());
-	const Eigen::AngleAxisf yaw(-(y / 50) * delta, Eigen::Vector3f::UnitZ());
-	mOwner->setRotation(dir * rot * yaw);
+	SDL_Gamepad* gamepad = mOwner->getGame()->getGamepad();
+	if (gamepad != nullptr) {
+		const float stickX = SDL_GetGamepadAxis(gamepad, SDL_GAMEPAD_AXIS_RIGHTX) / 32767.0f;
+		const float stickY = SDL_GetGamepadAxis(gamepad, SDL_GAMEPAD_AXIS_RIGHTY) / 32767.0f;
 
-	project();
-	view();
+		// A held stick sends no events, so it has to keep the frames coming
+		if (std::abs(stickX) > STICK_DEADZONE || std::abs(stickY) > STICK_DEADZONE) {
+			x += (std::abs(stickX) > STICK_DEADZONE ? stickX : 0.0f) * STICK_SPEED;
+			y += (std::abs(stickY) > STICK_DEADZONE ? stickY : 0.0f) * STICK_SPEED;
 
-	(void)delta;
+			mOwner->getGame()->redraw();
+		}
+	}
+
+	const Eigen::Quaternionf dir = mOwner->getRotation();
+	const Eigen::AngleAxisf rot(-x * delta, Eigen::Vector3f::UnitY());
+	const Eigen::AngleAxisf yaw(-y * delta, Eigen::Vector3f::UnitZ());
+	mOwner->setRotation(dir * rot * yaw);
 }
 
 void CameraComponent::view() {
@@ -48,11 +105,11 @@ void CameraComponent::view() {
 }
 
 void CameraComponent::project() {
-	const float near = 0.1f;
-	const float far = 100.0f;
+	const float near = mNear;
+	const float far = mFar;
 	const float aspect =
 		static_cast<float>(mOwner->getGame()->getWidth()) / mOwner->getGame()->getHeight();
-	float theta = mFOV * 0.5;
+	float theta = toRadians(mFOV) * 0.5f;
 	float range = far - near;
 	float invtan = 1.0f / tan(theta);
 
@@ -5,11 +5,21 @@
 #include "opengl/renderer.hpp"
 
 DrawComponent::DrawComponent(class Actor* owner, int drawOrder)
-	: Component(owner), mDrawOrder(drawOrder), mVisible(true), mVert("default.vert"), mFrag("default.frag"), mShader(nullptr) {
+	: Component(owner), mDrawOrder(drawOrder), mVisible(true), mCullable(true), mOccluder(false),
+	  mVert("default.vert"), mFrag("default.frag"), mShader(nullptr) {
 	mOwner->getGame()->getRenderer()->addSprite(this);
 	reload();
 }
 
 void DrawComponent::reload() {
-	mShader = mOwner->getGame()->getShader(mVert, mFrag);
+	mShader = mOwner->getGame()->getShader(mVert, mFrag, mDefines);
+}
+
+Eigen::Affine3f DrawComponent::getModelMatrix() const {
+	Eigen::Affine3f matrix = Eigen::Affine3f::Identity();
+	matrix.translate(mOwner->getPosition());
+	matrix.scale(mOwner->getScale());
+	matrix.rotate(mOwner->getRotation());
+
+	return matrix;
 }
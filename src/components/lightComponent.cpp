@@ -0,0 +1,69 @@
+#include "components/lightComponent.hpp"
+
+#include "actors/actor.hpp"
+#include "game.hpp"
+#include "opengl/renderer.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Brightness the range ends at, below what an 8 bit channel can show
+static constexpr float THRESHOLD = 1.0f / 256.0f;
+// Range of the lights without falloff, far enough to reach everything but finite for binning
+static constexpr float MAX_RANGE = 1.0e6f;
+
+LightComponent::LightComponent(Actor* owner)
+	: Component(owner), mColor(1.0f, 1.0f, 1.0f), mAttenuation(1.0f, 0.09f, 0.032f), mRange(0.0f),
+	  mSpot(false), mCutOff(-1.0f), mOuterCutOff(-1.0f), mEnabled(true) {
+	range();
+
+	mOwner->getGame()->getRenderer()->addLight(this);
+}
+
+LightComponent::~LightComponent() { mOwner->getGame()->getRenderer()->removeLight(this); }
+
+void LightComponent::setColor(const Eigen::Vector3f& color) {
+	mColor = color;
+	range();
+}
+
+void LightComponent::setAttenuation(float constant, float linear, float quadratic) {
+	mAttenuation = Eigen::Vector3f(constant, linear, quadratic);
+	range();
+}
+
+void LightComponent::setSpot(float inner, float outer) {
+	mSpot = true;
+	mCutOff = std::cos(toRadians(inner));
+	mOuterCutOff = std::cos(toRadians(std::max(inner, outer)));
+}
+
+void LightComponent::setPoint() {
+	mSpot = false;
+	mCutOff = -1.0f;
+	mOuterCutOff = -1.0f;
+}
+
+Eigen::Vector3f LightComponent::getPosition() const { return mOwner->getPosition(); }
+
+Eigen::Vector3f LightComponent::getDirection() const { return mOwner->getForward(); }
+
+// Solves color / (constant + linear * d + quadratic * d^2) = THRESHOLD for d
+void LightComponent::range() {
+	const float constant = mAttenuation.x() - mColor.maxCoeff() / THRESHOLD;
+	const float linear = mAttenuation.y();
+	const float quadratic = mAttenuation.z();
+
+	if (constant >= 0.0f) {
+		mRange = 0.0f;
+	} else if (quadratic > 0.0f) {
+		mRange = std::min((-linear + std::sqrt(linear * linear - 4.0f * quadratic * constant)) /
+							  (2.0f * quadratic),
+						  MAX_RANGE);
+	} else if (linear > 0.0f) {
+		mRange = std::min(-constant / linear, MAX_RANGE);
+	} else {
+		mRange = MAX_RANGE;
+	}
+}
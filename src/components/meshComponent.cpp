@@ -2,6 +2,8 @@
 
 #include "actors/actor.hpp"
 #include "opengl/mesh.hpp"
+#include "opengl/occlusionCuller.hpp"
+#include "opengl/renderQueue.hpp"
 #include "opengl/shader.hpp"
 #include "opengl/texture.hpp"
 #include "opengl/types.hpp"
@@ -17,16 +19,18 @@ MeshComponent::MeshComponent(Actor* owner, const std::vector<Vertex>& vertices,
 							 int drawOrder)
 	: DrawComponent(owner, drawOrder), mMesh(std::make_unique<Mesh>(vertices, indices, textures)) {}
 
-void MeshComponent::draw() {
+void MeshComponent::record(RenderQueue::Lane& lane) {
 	if (!getVisible()) {
 		return;
 	}
 
-	Eigen::Affine3f matrix = Eigen::Affine3f::Identity();
-	matrix.translate(mOwner->getPosition());
-	matrix.scale(mOwner->getScale());
-	matrix.rotate(mOwner->getRotation());
-	this->getShader()->set("model", matrix);
+	lane.push(mDrawOrder, getShader(), mMesh.get(), getModelMatrix(), mCullable);
+}
+
+void MeshComponent::occlude(OcclusionCuller& culler) {
+	if (!getVisible()) {
+		return;
+	}
 
-	mMesh->draw(this->getShader());
+	culler.add(*mMesh, getModelMatrix());
 }
@@ -3,8 +3,11 @@
 #include "actors/actor.hpp"
 #include "game.hpp"
 #include "opengl/mesh.hpp"
+#include "opengl/occlusionCuller.hpp"
+#include "opengl/renderQueue.hpp"
 #include "opengl/shader.hpp"
 #include "opengl/types.hpp"
+#include "profiler.hpp"
 #include "third_party/Eigen/Core"
 #include "utils.hpp"
 
@@ -16,24 +19,42 @@
 #include <string_view>
 #include <utility>
 
-ModelComponent::ModelComponent(Actor* owner, const std::string_view& path) : DrawComponent(owner) {
+ModelComponent::ModelComponent(Actor* owner, const std::string_view& path)
+	: DrawComponent(owner), mPath(path) {
+	load();
+}
+
+void ModelComponent::load() {
+	PROFILE_SCOPE("ModelComponent::load");
+
 	// TODO: SDL Importer
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile(
-		path.data(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_OptimizeMeshes);
+		mPath.data(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_OptimizeMeshes);
 	[[unlikely]] if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
 					 !scene->mRootNode) {
 		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to load model with assimp %s: \n%s\n",
-						path.data(), importer.GetErrorString());
+						mPath.data(), importer.GetErrorString());
 		ERROR_BOX("Failed to read assets, your assets are corrupted or you dont't have "
 				  "enough memory");
 
 		throw std::runtime_error("ModelComponent.cpp: Failed to read model");
 	}
 
+	for (const auto& mesh : mMeshes) {
+		delete mesh;
+	}
+	mMeshes.clear();
+
 	loadNode(scene->mRootNode, scene);
 
-	SDL_Log("Successfully loaded model: %s", path.data());
+	for (const auto& texture : mTextures) {
+		for (const auto& mesh : mMeshes) {
+			mesh->addTexture(texture);
+		}
+	}
+
+	SDL_Log("Successfully loaded model: %s", mPath.data());
 }
 
 ModelComponent::~ModelComponent() {
@@ -125,23 +146,33 @@ std::vector<Texture*> ModelComponent::loadTextures(aiMaterial* mat, const aiText
 	return textures;
 }
 
-void ModelComponent::draw() {
+void ModelComponent::record(RenderQueue::Lane& lane) {
 	if (!getVisible()) {
 		return;
 	}
 
-	Eigen::Affine3f matrix = Eigen::Affine3f::Identity();
-	matrix.translate(mOwner->getPosition());
-	matrix.scale(mOwner->getScale());
-	matrix.rotate(mOwner->getRotation());
-	this->getShader()->set("model", matrix);
+	const Eigen::Affine3f matrix = getModelMatrix();
 
 	for (const auto& mesh : mMeshes) {
-		mesh->draw(this->getShader());
+		lane.push(mDrawOrder, getShader(), mesh, matrix, mCullable);
+	}
+}
+
+void ModelComponent::occlude(OcclusionCuller& culler) {
+	if (!getVisible()) {
+		return;
+	}
+
+	const Eigen::Affine3f matrix = getModelMatrix();
+
+	for (const auto& mesh : mMeshes) {
+		culler.add(*mesh, matrix);
 	}
 }
 
 void ModelComponent::addTexture(std::pair<class Texture*, TextureType> texture) {
+	mTextures.emplace_back(texture);
+
 	for (const auto& mesh : mMeshes) {
 		mesh->addTexture(texture);
 	}
@@ -3,18 +3,39 @@
 #include "actors/actor.hpp"
 #include "actors/player.hpp"
 #include "actors/world.hpp"
+#include "benchmark.hpp"
+#include "cameraPath.hpp"
+#include "components/cameraComponent.hpp"
+#include "managers/fileWatcher.hpp"
+#include "managers/lightManager.hpp"
 #include "managers/shaderManager.hpp"
 #include "managers/textureManager.hpp"
+#include "opengl/framebuffer.hpp"
+#include "opengl/glState.hpp"
+#include "opengl/gpuProfiler.hpp"
+#include "opengl/occlusionCuller.hpp"
+#include "opengl/renderGraph.hpp"
+#include "opengl/renderQueue.hpp"
 #include "opengl/renderer.hpp"
+#include "profiler.hpp"
 #include "third_party/Eigen/src/Core/Matrix.h"
+#include "threadPool.hpp"
 #include "utils.hpp"
 
 #include <SDL3/SDL.h>
 #include <algorithm>
+#include <cfloat>
 #include <cstdint>
+#include <exception>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <third_party/Eigen/Dense>
 #include <third_party/glad/glad.h>
 
@@ -24,9 +45,21 @@
 #include <imgui.h>
 #endif
 
-Game::Game(std::string pano)
-	: mTextures(nullptr), mShaders(nullptr), mRenderer(nullptr), mUpdatingActors(false), mTicks(0),
-	  mBasePath(""), mPaused(false) {
+// Milliseconds to wait for events when nothing has to be drawn
+static constexpr Sint32 IDLE_WAIT = 100;
+static constexpr Sint32 HIDDEN_WAIT = 250;
+
+Game::Game(const Options& options)
+	: mOptions(options), mTextures(nullptr), mShaders(nullptr), mRenderer(nullptr),
+	  mUpdatingActors(false), mMainThread(std::this_thread::get_id()), mTicks(0), mBasePath(""),
+	  mPaused(false), mRedraw(REDRAW_FRAMES), mFrame(0), mUpdates(0), mGamepad(nullptr),
+	  mBenchmark(nullptr), mRecording(nullptr), mRecordingTime(0.0f), mUpdatePending(false),
+	  mUpdaterRunning(true), mUpdateError(nullptr), mSnapshotted(false) {
+	PROFILE_THREAD("Main");
+	PROFILE_SCOPE("Game::Game");
+
+	const uint64_t start = SDL_GetTicksNS();
+
 	const char* basepath = SDL_GetBasePath();
 	if (basepath != nullptr) {
 		mBasePath = std::string(basepath);
@@ -39,14 +72,53 @@ Game::Game(std::string pano)
 
 	mRenderer = new Renderer(this);
 
-	new World(this, pano);
+	new World(this, mOptions.pano);
 
 	setup();
+
+	mRenderer->setLowLatency(mOptions.lowLatency);
+	mRenderer->setReprojection(mOptions.reproject, mOptions.interval);
+
+	if (!mOptions.benchmark.empty()) {
+		startBenchmark(start);
+	}
+
+	// Not on single cores or with --threads 1, nor on the web without pthreads
+	if (mRenderer->getWorkers().getThreads() > 1) {
+		mUpdater = std::thread(&Game::updater, this);
+	}
 }
 
-#ifdef DEBUG
-#include <filesystem>
+// Everything that would make runs differ is turned off
+void Game::startBenchmark(uint64_t start) {
+	std::unique_ptr<CameraPath> path = nullptr;
+
+	if (mOptions.path.empty()) {
+		CameraComponent* camera = mRenderer->getCamera();
+		const Actor* owner = camera->getOwner();
+
+		path = CameraPath::orbit(owner->getPosition(), owner->getRotation(), camera->getFOV());
+	} else {
+		path = CameraPath::load(mOptions.path);
+
+		[[unlikely]] if (path == nullptr) {
+			throw std::runtime_error("game.cpp: Failed to load the camera path");
+		}
+	}
+
+	mBenchmark = std::make_unique<Benchmark>(this, std::move(path), start);
+
+	if (mOptions.frames == 0) {
+		mOptions.frames = mBenchmark->getFrames();
+	}
+
+	mRenderer->getFramebuffer()->setDynamic(false);
+	mRenderer->setLowLatency(false);
+	mRenderer->setReprojection(false, 0);
+#ifndef HEADLESS
+	SDL_GL_SetSwapInterval(0);
 #endif
+}
 
 void Game::setup() {
 	SDL_Log("Setting up game");
@@ -56,17 +128,20 @@ void Game::setup() {
 	mTicks = SDL_GetTicks();
 
 #ifdef DEBUG
-	last_time = std::filesystem::last_write_time(fullPath("shaders"));
+	mWatcher = std::make_unique<FileWatcher>(mBasePath);
 #endif
 
 	SDL_Log("Successfully initialized OpenGL and game\n");
 }
 
 int Game::iterate() {
-	if (mPaused) {
+	// Waiting doesn't take the events, they are still handled by event
+	if (mPaused || !mRenderer->isVisible()) {
 		mTicks = SDL_GetTicks();
 
-		SDL_Delay(64);
+#ifndef __EMSCRIPTEN__
+		SDL_WaitEventTimeout(nullptr, mPaused ? 64 : HIDDEN_WAIT);
+#endif
 
 		return 0;
 	}
@@ -76,17 +151,91 @@ int Game::iterate() {
 #endif
 
 #ifdef DEBUG
-	if (std::filesystem::last_write_time(fullPath("shaders")) != last_time) {
-		last_time = std::filesystem::last_write_time(fullPath("shaders"));
+	if (mWatcher->pending()) {
+		reloadAssets();
+	}
+#endif
+
+	// Sleeping here instead of after the last swap samples the input closer to the next refresh
+	if (mRenderer->isLowLatency() && mOptions.delay > 0 && mRedraw > 0) {
+		PROFILE_SCOPE("Game::delay");
 
-		mShaders->reload();
+		SDL_DelayPrecise(static_cast<uint64_t>(mOptions.delay) * 1000000);
 	}
+
+	// The keyboard would move the camera off the path
+	if (!mBenchmark) {
+		input();
+	}
+
+	// The next frame's update runs while this one is drawn, so input shows a frame later. Low
+	// latency mode latches the camera right before drawing, which needs the update done by then
+	const bool pipelined = mUpdater.joinable() && !mRenderer->isLowLatency();
+	if (!pipelined || !mSnapshotted) {
+		update();
+		reap();
+	}
+
+	// Frames that are captured or counted are always drawn, so are benchmarks
+	const bool driven = mOptions.frames != 0 || mRenderer->getFramebuffer()->isCapturing();
+
+	// Nothing moved or changed, sleep until something happens instead of drawing the same frame
+	// Actors can still change on their own, so they are updated every now and then
+	if (mRedraw == 0 && !driven) {
+		mSnapshotted = false;
+
+#ifndef __EMSCRIPTEN__
+		SDL_WaitEventTimeout(nullptr, IDLE_WAIT);
 #endif
 
+		return 0;
+	}
+
 	gui();
-	input();
-	update();
-	draw();
+
+	if (pipelined) {
+		if (!mSnapshotted) {
+			mRenderer->snapshot();
+		}
+
+		// Drawing only reads the snapshot, the actors are free to move on
+		startUpdate();
+		draw();
+		finishUpdate();
+		reap();
+
+		mRenderer->snapshot();
+		mSnapshotted = true;
+	} else {
+		// Taken after latching the camera in low latency mode
+		if (!mRenderer->isLowLatency()) {
+			mRenderer->snapshot();
+		}
+		mSnapshotted = false;
+
+		draw();
+	}
+
+	// Reprojected frames don't show the changes, the last one has to be a scene
+	if (mRedraw > 0 && mRenderer->drewScene()) {
+		mRedraw--;
+	}
+	PROFILE_FRAME();
+
+	if (mBenchmark) {
+		mBenchmark->frame();
+	}
+
+	mFrame++;
+	if (mOptions.frames != 0 && mFrame >= mOptions.frames) {
+		SDL_Log("Drew %u frames", mFrame);
+
+		if (mBenchmark) {
+			mBenchmark->report(mOptions.benchmark);
+		}
+
+		return 1;
+	}
 
 #ifdef DEBUG
 	// TODO:
@@ -117,7 +266,51 @@ int Game::iterate() {
 	return 0;
 }
 
+#ifdef DEBUG
+// Only the assets that changed on disk are rebuilt
+void Game::reloadAssets() {
+	PROFILE_SCOPE("Game::reloadAssets");
+
+	bool shaders = false;
+
+	for (const auto& [type, file] : mWatcher->poll()) {
+		SDL_Log("Asset changed: %s", file.data());
+
+		switch (type) {
+			case FileWatcher::SHADER:
+				mShaders->reload(file);
+				shaders = true;
+				break;
+			case FileWatcher::TEXTURE:
+				mTextures->reload(file);
+				break;
+			case FileWatcher::MODEL:
+				mRenderer->reloadModel(fullPath("models" SEPARATOR + file));
+				break;
+		}
+	}
+
+	// Drawables cache their shader pointer
+	if (shaders) {
+		mRenderer->reload();
+	}
+	resnapshot();
+
+	redraw();
+}
+#endif
+
+// The pipelined snapshot is drawn next iteration, its packets would point at the replaced meshes
+// and shaders. The update it was taken after already ran, so only the snapshot is taken again
+void Game::resnapshot() {
+	if (mSnapshotted) {
+		mRenderer->snapshot();
+	}
+}
+
 void Game::input() {
+	PROFILE_SCOPE("Game::input");
+
 	const uint8_t* keys = SDL_GetKeyboardState(nullptr);
 
 	mUpdatingActors = true;
@@ -128,6 +321,8 @@ void Game::input() {
 }
 
 void Game::update() {
+	PROFILE_SCOPE("Game::update");
+
 	// Update the game
 	float delta = static_cast<float>(SDL_GetTicks() - mTicks) / 1000.0f;
 	if (delta > 0.05) {
@@ -135,12 +330,38 @@ void Game::update() {
 	}
 	mTicks = SDL_GetTicks();
 
+	// Benchmarks step the same every frame, however long the frames take
+	if (mBenchmark) {
+		delta = Benchmark::STEP;
+
+		mBenchmark->update(mRenderer->getCamera(), mUpdates);
+	}
+
 	// Update the Actors
 	mUpdatingActors = true;
 	for (auto& actor : mActors) {
 		actor->update(delta);
 	}
 	mUpdatingActors = false;
+	mUpdates++;
+
+	if (mRecording) {
+		CameraComponent* camera = mRenderer->getCamera();
+		const Actor* owner = camera->getOwner();
+
+		mRecording->add(
+			{mRecordingTime, owner->getPosition(), owner->getRotation(), camera->getFOV()});
+		mRecordingTime += delta;
+	}
+}
+
+void Game::reap() {
+	// Spawns can spawn again, those run after the next update
+	std::vector<std::function<void()>> spawns;
+	spawns.swap(mSpawns);
+	for (const auto& make : spawns) {
+		make();
+	}
 
 	// Append the pending actors
 	std::copy(mPendingActors.begin(), mPendingActors.end(), std::back_inserter(mActors));
@@ -157,10 +378,119 @@ void Game::update() {
 	}
 }
 
+void Game::updater() {
+	PROFILE_THREAD("Update");
+
+	std::unique_lock<std::mutex> lock(mUpdateMutex);
+
+	while (true) {
+		mUpdateCondition.wait(lock, [this] { return mUpdatePending || !mUpdaterRunning; });
+		if (!mUpdaterRunning) {
+			return;
+		}
+
+		lock.unlock();
+		try {
+			update();
+		} catch (...) {
+			mUpdateError = std::current_exception();
+		}
+		lock.lock();
+
+		mUpdatePending = false;
+		mUpdateCondition.notify_all();
+	}
+}
+
+void Game::startUpdate() {
+	{
+		const std::lock_guard<std::mutex> lock(mUpdateMutex);
+		mUpdatePending = true;
+	}
+	mUpdateCondition.notify_all();
+}
+
+void Game::finishUpdate() {
+	PROFILE_SCOPE("Game::finishUpdate");
+
+	std::unique_lock<std::mutex> lock(mUpdateMutex);
+	mUpdateCondition.wait(lock, [this] { return !mUpdatePending; });
+
+	if (mUpdateError) {
+		std::rethrow_exception(std::exchange(mUpdateError, nullptr));
+	}
+}
+
+#if defined(IMGUI) && defined(PROFILE)
+// One row per nesting depth, every thread below the one before
+static void drawFlame(const std::vector<Profiler::Thread>& threads, uint64_t start, uint64_t end) {
+	if (end <= start) {
+		ImGui::Text("Waiting for a frame");
+
+		return;
+	}
+
+	ImGui::Text("%.3f ms frame", static_cast<double>(end - start) / 1000000.0);
+
+	ImDrawList* list = ImGui::GetWindowDrawList();
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+	const float row = ImGui::GetTextLineHeightWithSpacing();
+	const float scale = width / static_cast<float>(end - start);
+
+	float y = origin.y;
+	for (const Profiler::Thread& thread : threads) {
+		if (thread.events.empty()) {
+			continue;
+		}
+
+		list->AddText(ImVec2(origin.x, y), IM_COL32(255, 255, 255, 255), thread.name.data());
+		y += row;
+
+		unsigned int depth = 0;
+		for (const Profiler::Event& event : thread.events) {
+			depth = std::max(depth, event.depth);
+
+			// Scopes that began in the frame before start at the edge
+			const float x0 =
+				origin.x + static_cast<float>(std::max(event.start, start) - start) * scale;
+			const float x1 =
+				std::max(origin.x + static_cast<float>(event.end - start) * scale, x0 + 1.0f);
+			const float y0 = y + static_cast<float>(event.depth) * row;
+			const ImVec2 min(x0, y0);
+			const ImVec2 max(x1, y0 + row - 1.0f);
+
+			// The same scope keeps its color between frames
+			const float hue =
+				static_cast<float>(std::hash<std::string_view>{}(event.name) % 360) / 360.0f;
+			list->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.6f));
+
+			if (ImGui::CalcTextSize(event.name).x < x1 - x0) {
+				list->PushClipRect(min, max, true);
+				list->AddText(min, IM_COL32(255, 255, 255, 255), event.name);
+				list->PopClipRect();
+			}
+
+			if (ImGui::IsMouseHoveringRect(min, max)) {
+				ImGui::SetTooltip("%s: %.3f ms", event.name,
+								  static_cast<double>(event.end - event.start) / 1000000.0);
+			}
+		}
+
+		y += static_cast<float>(depth + 1) * row;
+	}
+
+	ImGui::Dummy(ImVec2(width, y - origin.y));
+}
+#endif
+
 void Game::gui() {
 #ifdef IMGUI
+	PROFILE_SCOPE("Game::gui");
+
 	static bool demoMenu = false;
-	static bool vsync = true;
+	// Benchmarks aren't held to the refresh rate
+	static bool vsync = !mBenchmark;
 	static bool wireframe = false;
 
 	// Update ImGui Frame
@@ -168,6 +498,50 @@ void Game::gui() {
 	ImGui_ImplSDL3_NewFrame();
 	ImGui::NewFrame();
 
+	/* GPU passes */ {
+		const GPUProfiler* profiler = GPUProfiler::get();
+
+		ImGui::Begin("GPU passes");
+
+		if (profiler == nullptr || !profiler->isSupported()) {
+			ImGui::Text("No timer queries");
+		} else {
+			const auto& history = profiler->getHistory();
+			ImGui::PlotLines("##history", history.data(), static_cast<int>(history.size()),
+							 static_cast<int>(profiler->getHistoryOffset()), "ms", 0.0f, FLT_MAX,
+							 ImVec2(0.0f, 60.0f));
+
+			for (const GPUProfiler::Pass& pass : profiler->getPasses()) {
+				ImGui::Indent(static_cast<float>(pass.depth + 1) * 8.0f);
+				ImGui::Text("%-24s %6.3f ms", pass.name.data(), pass.time);
+				ImGui::Unindent(static_cast<float>(pass.depth + 1) * 8.0f);
+			}
+		}
+
+		ImGui::End();
+	}
+
+#ifdef PROFILE
+	/* CPU profile */ {
+		static bool paused = false;
+		static std::vector<Profiler::Thread> threads;
+		static uint64_t start = 0;
+		static uint64_t end = 0;
+
+		ImGui::Begin("CPU profile");
+
+		ImGui::Checkbox("Pause", &paused);
+		if (!paused) {
+			Profiler::getFrame(start, end);
+			threads = Profiler::collect(start, end);
+		}
+
+		drawFlame(threads, start, end);
+
+		ImGui::End();
+	}
+#endif
+
 	/* Main menu */ {
 		ImGui::Begin("Main menu");
 
@@ -175,6 +549,13 @@ void Game::gui() {
 		ImGui::Text("Average %.3f ms/frame (%.1f FPS)", (1000.f / io.Framerate), io.Framerate);
 		ImGui::Text("%d vertices, %d indices (%d triangles)", io.MetricsRenderVertices,
 					io.MetricsRenderIndices, io.MetricsRenderIndices / 3);
+		ImGui::Text("%u GL state calls, %u elided", GLState::getStats().calls,
+					GLState::getStats().elided);
+		ImGui::Text("%zu draws, %u culled, recorded in %zu lanes on %u threads",
+					mRenderer->getQueue().packets().size(), mRenderer->getQueue().getCulled(),
+					mRenderer->getQueue().getLanes(), mRenderer->getWorkers().getThreads());
+		ImGui::Text("%.0f%% resolution, %.2f ms GPU", mRenderer->getFramebuffer()->getScale() * 100.0f,
+					mRenderer->getFramebuffer()->getGPUTime());
 
 		Player* p = nullptr;
 		for (const auto& actor : mActors) {
@@ -196,6 +577,57 @@ void Game::gui() {
 		ImGui::Checkbox("VSync", &vsync);
 		ImGui::Checkbox("Wireframe", &wireframe);
 
+		bool dynamic = mRenderer->getFramebuffer()->getDynamic();
+		if (ImGui::Checkbox("Dynamic resolution", &dynamic)) {
+			mRenderer->getFramebuffer()->setDynamic(dynamic);
+		}
+
+		bool lowLatency = mRenderer->isLowLatency();
+		if (ImGui::Checkbox("Low latency", &lowLatency)) {
+			mRenderer->setLowLatency(lowLatency);
+		}
+		if (lowLatency) {
+			int delay = static_cast<int>(mOptions.delay);
+			if (ImGui::SliderInt("Frame delay", &delay, 0, 12, "%d ms")) {
+				mOptions.delay = static_cast<unsigned int>(delay);
+			}
+		}
+
+		bool occlude = mRenderer->isOccluding();
+		if (ImGui::Checkbox("Occlusion culling", &occlude)) {
+			mRenderer->setOcclusion(occlude);
+		}
+		if (occlude) {
+			const OcclusionCuller::Stats occlusion = mRenderer->getOcclusion().getStats();
+			ImGui::Text("%u occluders, %u triangles, %u draws occluded", occlusion.occluders,
+						occlusion.triangles, mRenderer->getQueue().getOccluded());
+		}
+
+		bool reproject = mRenderer->isReprojecting();
+		int interval = static_cast<int>(mRenderer->getInterval());
+		if (ImGui::Checkbox("Reprojection", &reproject)) {
+			mRenderer->setReprojection(reproject, static_cast<unsigned int>(interval));
+		}
+		if (reproject && ImGui::SliderInt("Scene interval", &interval, 0,
+										  static_cast<int>(Renderer::MAX_INTERVAL),
+										  interval == 0 ? "automatic" : "%d refreshes")) {
+			mRenderer->setReprojection(reproject, static_cast<unsigned int>(interval));
+		}
+
+		Framebuffer::Effects& effects = mRenderer->getFramebuffer()->getEffects();
+		ImGui::SliderFloat("Blur", &effects.blur, 0.0f, 8.0f, "%.1f px");
+		ImGui::SliderFloat("Sharpen", &effects.sharpen, 0.0f, 1.0f);
+		ImGui::SliderFloat("Exposure", &effects.exposure, 0.25f, 4.0f);
+		ImGui::SliderFloat("Vignette", &effects.vignette, 0.0f, 1.0f);
+
+		const RenderGraph::Stats post = mRenderer->getFramebuffer()->getPostStats();
+		ImGui::Text("%u post passes, %u culled, %u merged, %u targets", post.declared, post.culled,
+					post.merged, post.targets);
+
+		const LightManager::Stats lights = mRenderer->getLights()->getStats();
+		ImGui::Text("%u lights, %u in view, %u cluster entries, at most %u in one", lights.lights,
+					lights.visible, lights.indices, lights.busiest);
+
 		ImGui::End();
 	}
 
@@ -203,17 +635,17 @@ void Game::gui() {
 		ImGui::ShowDemoWindow(&demoMenu);
 	}
 
-	if (wireframe) {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	} else {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-	}
+	GLState::polygonMode(wireframe ? GL_LINE : GL_FILL);
 
 	SDL_GL_SetSwapInterval(static_cast<int>(vsync));
 #endif
 }
 
-void Game::draw() { mRenderer->draw(); }
+void Game::draw() {
+	PROFILE_SCOPE("Game::draw");
+
+	mRenderer->draw();
+}
 
 int Game::event(const SDL_Event& event) {
 #ifdef IMGUI
@@ -222,6 +654,9 @@ int Game::event(const SDL_Event& event) {
 
 	static bool rel = true;
 
+	// Input, ImGui and window events can all change the frame
+	redraw();
+
 	switch (event.type) {
 		case SDL_EVENT_QUIT: {
 			return 1;
@@ -246,14 +681,63 @@ int Game::event(const SDL_Event& event) {
 					mPaused = false;
 				}
 #endif
-				// mTextures->reload(true);
-				// TODO: Maybe textures
-				mShaders->reload(true);
+				mShaders->reload();
+				mTextures->reload();
 				mRenderer->reload();
+				resnapshot();
 			}
 			if (event.key.key == SDLK_F3) {
 				mPaused = !mPaused;
 			}
+			if (event.key.key == SDLK_F4) {
+				if (mRenderer->getFramebuffer()->isCapturing()) {
+					mRenderer->getFramebuffer()->stopCapture();
+				} else {
+					mRenderer->startCapture(mOptions.output.empty() ? mBasePath + "captures"
+																	: mOptions.output);
+				}
+			}
+			if (event.key.key == SDLK_F6) {
+				if (mRecording) {
+					mRecording->save(mOptions.record.empty() ? mBasePath + "camera.path"
+															 : mOptions.record);
+					mRecording = nullptr;
+				} else {
+					SDL_Log("Recording the camera path");
+
+					mRecording = std::make_unique<CameraPath>();
+					mRecordingTime = 0.0f;
+				}
+			}
+#ifdef PROFILE
+			if (event.key.key == SDLK_F5) {
+				Profiler::write(mOptions.trace.empty() ? mBasePath + "trace.json" : mOptions.trace);
+			}
+#endif
+			break;
+		}
+
+		case SDL_EVENT_GAMEPAD_ADDED: {
+			if (mGamepad == nullptr) {
+				mGamepad = SDL_OpenGamepad(event.gdevice.which);
+
+				if (mGamepad == nullptr) {
+					SDL_LogError(SDL_LOG_CATEGORY_INPUT, "Failed to open the gamepad: %s\n",
+								 SDL_GetError());
+				} else {
+					SDL_Log("Gamepad: %s", SDL_GetGamepadName(mGamepad));
+				}
+			}
+
+			break;
+		}
+
+		case SDL_EVENT_GAMEPAD_REMOVED: {
+			if (mGamepad != nullptr && SDL_GetGamepadID(mGamepad) == event.gdevice.which) {
+				SDL_CloseGamepad(mGamepad);
+				mGamepad = nullptr;
+			}
+
 			break;
 		}
 
@@ -268,6 +752,15 @@ int Game::event(const SDL_Event& event) {
 }
 
 void Game::addActor(Actor* actor) {
+	[[unlikely]] if (std::this_thread::get_id() != mMainThread) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+					 "Actors made during the update have to be made with Game::spawn\n");
+
+		throw std::runtime_error("game.cpp: Actor made off the main thread");
+	}
+
+	redraw();
+
 	if (!mUpdatingActors) {
 		mActors.emplace_back(actor);
 	} else {
@@ -275,7 +768,11 @@ void Game::addActor(Actor* actor) {
 	}
 }
 
+void Game::spawn(std::function<void()> make) { mSpawns.emplace_back(std::move(make)); }
+
 void Game::removeActor(Actor* actor) {
+	redraw();
+
 	auto iter = std::find(mPendingActors.begin(), mPendingActors.end(), actor);
 	if (iter != mPendingActors.end()) {
 		std::iter_swap(iter, mPendingActors.end() - 1);
@@ -290,13 +787,31 @@ void Game::removeActor(Actor* actor) {
 }
 
 Texture* Game::getTexture(const std::string& name) { return mTextures->get(name); }
-Shader* Game::getShader(const std::string& vert, const std::string& frag) {
-	return mShaders->get(vert, frag);
+Shader* Game::getShader(const std::string& vert, const std::string& frag,
+						const ShaderDefines& defines) {
+	return mShaders->get(vert, frag, defines);
 }
 
 Game::~Game() {
 	SDL_Log("Quitting game\n");
 
+	// Lets an update that is still running finish, like when drawing threw
+	if (mUpdater.joinable()) {
+		{
+			const std::lock_guard<std::mutex> lock(mUpdateMutex);
+			mUpdaterRunning = false;
+		}
+		mUpdateCondition.notify_all();
+
+		mUpdater.join();
+	}
+
+#ifdef PROFILE
+	if (!mOptions.trace.empty()) {
+		Profiler::write(mOptions.trace);
+	}
+#endif
+
 #ifdef IMGUI
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplSDL3_Shutdown();
@@ -311,6 +826,10 @@ Game::~Game() {
 	}
 
 	delete mRenderer;
+
+	if (mGamepad != nullptr) {
+		SDL_CloseGamepad(mGamepad);
+	}
 }
 
 [[nodiscard]] int Game::getWidth() const { return mRenderer->getWidth(); }
@@ -1,4 +1,5 @@
 #include "game.hpp"
+#include "options.hpp"
 #include "utils.hpp"
 
 #include <SDL3/SDL.h>
@@ -11,12 +12,13 @@
 
 #include <cstdlib>
 #include <ctime>
+#include <optional>
 #include <stdexcept>
 #include <string>
 
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
-	if (argc != 2) {
-		SDL_Log("Usage: ./Panorama [file]");
+	const std::optional<Options> options = Options::parse(argc, argv);
+	if (!options) {
 		return SDL_APP_FAILURE;
 	}
 
@@ -26,16 +28,24 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
 
 	SDL_SetHint(SDL_HINT_ORIENTATIONS, "LandscapeLeft");
 
-	if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMEPAD)) {
+#ifdef HEADLESS
+	// There might not be a display to initialize the video with
+	const SDL_InitFlags flags = SDL_INIT_EVENTS | SDL_INIT_TIMER;
+#else
+	const SDL_InitFlags flags = SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMEPAD;
+#endif
+
+	if (!SDL_Init(flags)) {
 		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to init SDL: %s\n", SDL_GetError());
 		ERROR_BOX("Failed to initialize SDL, there is something wrong with your system");
 		return SDL_APP_FAILURE;
 	}
 
 	try {
-		*appstate = new Game(argv[1]);
-	} catch (std::runtime_error e) {
+		*appstate = new Game(*options);
+	} catch (const std::runtime_error& e) {
 		SDL_Log("Error: %s", e.what());
+		return SDL_APP_FAILURE;
 	} catch (...) {
 		SDL_Log("Uncaught exception");
 		return SDL_APP_FAILURE;
@@ -58,8 +68,9 @@ SDL_AppResult SDL_AppEvent(void* appstate, const SDL_Event* event) {
 
 SDL_AppResult SDL_AppIterate(void* appstate) {
 	try {
+		// Only done after drawing the requested frames
 		if (static_cast<Game*>(appstate)->iterate()) {
-			return SDL_APP_FAILURE;
+			return SDL_APP_SUCCESS;
 		} else {
 			return SDL_APP_CONTINUE;
 		}
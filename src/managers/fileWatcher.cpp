@@ -0,0 +1,191 @@
+#include "managers/fileWatcher.hpp"
+
+#include "utils.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <array>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#endif
+
+static const std::string DIRECTORIES[] = {"shaders", "textures", "models"};
+
+void FileWatcher::push(Type type, const std::string& file) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+
+	const Event event = {type, file};
+	if (std::find(mEvents.begin(), mEvents.end(), event) == mEvents.end()) {
+		mEvents.emplace_back(event);
+	}
+
+	mPending.store(true, std::memory_order_release);
+}
+
+std::vector<FileWatcher::Event> FileWatcher::poll() {
+	const std::lock_guard<std::mutex> lock(mMutex);
+
+	std::vector<Event> events;
+	events.swap(mEvents);
+	mPending.store(false, std::memory_order_release);
+
+	return events;
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+FileWatcher::FileWatcher(const std::string& path)
+	: mPath(path + "assets" + SEPARATOR), mPending(false), mRunning(true),
+	  mInotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), mWake{-1, -1} {
+	if (mInotify == -1 || pipe(mWake) == -1) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start watching the assets\n");
+
+		return;
+	}
+
+	for (unsigned int i = 0; i < std::size(DIRECTORIES); i++) {
+		watch(mPath + DIRECTORIES[i], static_cast<Type>(i), "");
+	}
+
+	mThread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher() {
+	mRunning = false;
+
+	if (mThread.joinable()) {
+		const char wake = 0;
+		[[maybe_unused]] const ssize_t written = write(mWake[1], &wake, 1);
+
+		mThread.join();
+	}
+
+	for (const int fd : {mInotify, mWake[0], mWake[1]}) {
+		if (fd != -1) {
+			close(fd);
+		}
+	}
+}
+
+// inotify isn't recursive, so every subdirectory gets its own watch
+void FileWatcher::watch(const std::string& directory, Type type, const std::string& prefix) {
+	const int wd = inotify_add_watch(mInotify, directory.data(),
+									 IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+	if (wd == -1) {
+		SDL_Log("Failed to watch %s", directory.data());
+
+		return;
+	}
+
+	mWatches[wd] = {type, prefix};
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (entry.is_directory()) {
+			const std::string name = entry.path().filename().string();
+
+			watch(entry.path().string(), type, prefix + name + SEPARATOR);
+		}
+	}
+}
+
+void FileWatcher::run() {
+	alignas(inotify_event) std::array<char, 4096> buffer;
+
+	std::array<pollfd, 2> fds = {{{mInotify, POLLIN, 0}, {mWake[0], POLLIN, 0}}};
+
+	while (mRunning) {
+		if (::poll(fds.data(), fds.size(), -1) <= 0 || !mRunning) {
+			continue;
+		}
+
+		ssize_t length = 0;
+		while ((length = read(mInotify, buffer.data(), buffer.size())) > 0) {
+			for (char* ptr = buffer.data(); ptr < buffer.data() + length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+				ptr += sizeof(inotify_event) + event->len;
+
+				if (event->len == 0 || !mWatches.contains(event->wd)) {
+					continue;
+				}
+
+				const Directory directory = mWatches[event->wd];
+				const std::string file = directory.prefix + event->name;
+
+				if (event->mask & IN_ISDIR) {
+					watch(mPath + DIRECTORIES[directory.type] + SEPARATOR + file, directory.type,
+						  file + SEPARATOR);
+				} else if (!(event->mask & IN_CREATE)) {
+					// Created files are reported once they are written
+					push(directory.type, file);
+				}
+			}
+		}
+	}
+}
+#else
+// No inotify, poll the modification times on the thread instead
+FileWatcher::FileWatcher(const std::string& path)
+	: mPath(path + "assets" + SEPARATOR), mPending(false), mRunning(true) {
+#ifndef __EMSCRIPTEN__
+	scan(false);
+
+	mThread = std::thread(&FileWatcher::run, this);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+	mStop.notify_all();
+
+	if (mThread.joinable()) {
+		mThread.join();
+	}
+}
+
+void FileWatcher::scan(bool report) {
+	for (unsigned int i = 0; i < std::size(DIRECTORIES); i++) {
+		const std::filesystem::path directory = mPath + DIRECTORIES[i];
+
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+			if (!entry.is_regular_file(error)) {
+				continue;
+			}
+
+			const std::filesystem::file_time_type time = entry.last_write_time(error);
+			const std::string file = entry.path().lexically_relative(directory).string();
+
+			auto [iter, inserted] = mLastEdit.try_emplace(entry.path().string(), time);
+			if (inserted || iter->second != time) {
+				iter->second = time;
+
+				if (report) {
+					push(static_cast<Type>(i), file);
+				}
+			}
+		}
+	}
+}
+
+void FileWatcher::run() {
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while (!mStop.wait_for(lock, std::chrono::milliseconds(250), [this] { return !mRunning; })) {
+		lock.unlock();
+		scan(true);
+		lock.lock();
+	}
+}
+#endif
@@ -1,12 +1,161 @@
 #include "managers/glManager.hpp"
 
+#include "opengl/glState.hpp"
 #include "third_party/glad/glad.h"
 #include "utils.hpp"
 
 #include <SDL3/SDL.h>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
+#ifdef HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef HEADLESS
+GLManager::GLManager() : mDisplay(EGL_NO_DISPLAY), mContext(EGL_NO_CONTEXT), mSurface(EGL_NO_SURFACE) {}
+
+static bool eglExtensionSupported(EGLDisplay display, const char* name) {
+	const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+	if (extensions == nullptr) {
+		return false;
+	}
+
+	// Whole names only, a name can be the start of another
+	const size_t length = std::strlen(name);
+	for (const char* match = std::strstr(extensions, name); match != nullptr;
+		 match = std::strstr(match + length, name)) {
+		if ((match == extensions || match[-1] == ' ') &&
+			(match[length] == ' ' || match[length] == '\0')) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void GLManager::bindContext() {
+	// Surfaceless needs neither a display server nor a GPU, Mesa's llvmpipe works too
+	if (eglExtensionSupported(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+		const PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+				eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+		if (getPlatformDisplay != nullptr) {
+			mDisplay =
+				getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+	}
+	if (mDisplay == EGL_NO_DISPLAY) {
+		mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	[[unlikely]] if (mDisplay == EGL_NO_DISPLAY ||
+					 eglInitialize(mDisplay, nullptr, nullptr) == EGL_FALSE) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to initialize EGL: 0x%x\n", eglGetError());
+
+		throw std::runtime_error("glManager.cpp: Failed to initialize EGL");
+	}
+
+#ifdef GLES
+	eglBindAPI(EGL_OPENGL_ES_API);
+	const EGLint renderable = EGL_OPENGL_ES3_BIT;
+	const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 0,
+										EGL_NONE};
+#else
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint renderable = EGL_OPENGL_BIT;
+	const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+										4,
+										EGL_CONTEXT_MINOR_VERSION,
+										0,
+										EGL_CONTEXT_OPENGL_PROFILE_MASK,
+										EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+										EGL_NONE};
+#endif
+
+	// The scene has its own depth and stencil in the framebuffer, the config only needs a pbuffer
+	// for drivers without surfaceless contexts
+	const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE,
+									   renderable, EGL_NONE};
+
+	EGLConfig config = nullptr;
+	EGLint configs = 0;
+	if (eglChooseConfig(mDisplay, configAttributes, &config, 1, &configs) == EGL_FALSE ||
+		configs == 0) {
+		config = nullptr;
+	}
+
+	const bool surfaceless = eglExtensionSupported(mDisplay, "EGL_KHR_surfaceless_context");
+
+	// Surfaceless platforms might not have any configs, a context doesn't need one then
+	if (config == nullptr &&
+		!(surfaceless && eglExtensionSupported(mDisplay, "EGL_KHR_no_config_context"))) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "No EGL config to render with\n");
+
+		throw std::runtime_error("glManager.cpp: Failed to find an EGL config");
+	}
+
+	mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+	[[unlikely]] if (mContext == EGL_NO_CONTEXT) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to create EGL context: 0x%x\n",
+						eglGetError());
+
+		throw std::runtime_error("glManager.cpp: Failed to get opengl context");
+	}
+
+	if (!surfaceless) {
+		const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+
+		mSurface = eglCreatePbufferSurface(mDisplay, config, surfaceAttributes);
+	}
+
+	[[unlikely]] if (eglMakeCurrent(mDisplay, mSurface, mSurface, mContext) == EGL_FALSE) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to make EGL context current: 0x%x\n",
+						eglGetError());
+
+		throw std::runtime_error("glManager.cpp: Failed to make opengl context current");
+	}
+
+	setup();
+}
+
+GLManager::~GLManager() {
+	if (mDisplay == EGL_NO_DISPLAY) {
+		return;
+	}
+
+	eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if (mSurface != EGL_NO_SURFACE) {
+		eglDestroySurface(mDisplay, mSurface);
+	}
+	if (mContext != EGL_NO_CONTEXT) {
+		eglDestroyContext(mDisplay, mContext);
+	}
+
+	eglTerminate(mDisplay);
+}
+
+SDL_FunctionPointer GLManager::getProcAddress(const char* name) {
+	return reinterpret_cast<SDL_FunctionPointer>(eglGetProcAddress(name));
+}
+
+bool GLManager::extensionSupported(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; i++) {
+		if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+#else
 GLManager::GLManager() : mContext(nullptr) {
 #ifdef __APPLE__
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
@@ -35,10 +184,27 @@ void GLManager::bindContext(SDL_Window* window) {
 		throw std::runtime_error("glManager.cpp: Failed to get opengl context");
 	}
 
+	setup();
+
+	SDL_GL_MakeCurrent(window, mContext);
+
+	SDL_GL_SetSwapInterval(1);
+}
+
+GLManager::~GLManager() { SDL_GL_DestroyContext(mContext); }
+
+SDL_FunctionPointer GLManager::getProcAddress(const char* name) {
+	return SDL_GL_GetProcAddress(name);
+}
+
+bool GLManager::extensionSupported(const char* name) { return SDL_GL_ExtensionSupported(name); }
+#endif
+
+void GLManager::setup() {
 #ifdef GLES
-	if (gladLoadGLES2Loader(reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
+	if (gladLoadGLES2Loader(reinterpret_cast<GLADloadproc>(getProcAddress)) == 0) {
 #else
-	if (gladLoadGLLoader(reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
+	if (gladLoadGLLoader(reinterpret_cast<GLADloadproc>(getProcAddress)) == 0) {
 #endif
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to init glad!\n");
 		ERROR_BOX("Failed to initialize GLAD, there is something wrong with your OpenGL");
@@ -46,27 +212,29 @@ void GLManager::bindContext(SDL_Window* window) {
 		throw std::runtime_error("glManager.cpp: Failed to init glad");
 	}
 
-	SDL_GL_MakeCurrent(window, mContext);
-
-	SDL_GL_SetSwapInterval(1);
+	// New context, nothing known is bound
+	GLState::reset();
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LEQUAL);
+	GLState::enable(GL_DEPTH_TEST);
+	GLState::depthFunc(GL_LEQUAL);
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	GLState::enable(GL_CULL_FACE);
+	GLState::cullFace(GL_BACK);
 
-	glEnable(GL_STENCIL_TEST);
+	GLState::enable(GL_STENCIL_TEST);
 	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::enable(GL_BLEND);
+	GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-GLManager::~GLManager() { SDL_GL_DestroyContext(mContext); }
-
 void GLManager::printInfo() {
+#ifdef HEADLESS
+	SDL_Log("EGL         : %s %s\n", eglQueryString(eglGetCurrentDisplay(), EGL_VENDOR),
+			eglQueryString(eglGetCurrentDisplay(), EGL_VERSION));
+#else
 	SDL_Log("Video driver: %s\n", SDL_GetCurrentVideoDriver());
+#endif
 	SDL_Log("Vendor      : %s\n", glGetString(GL_VENDOR));
 	SDL_Log("Renderer    : %s\n", glGetString(GL_RENDERER));
 	SDL_Log("Version     : %s\n", glGetString(GL_VERSION));
@@ -83,9 +251,11 @@ void GLManager::printInfo() {
 
 	GLint maj = 0;
 	GLint min = 0;
+#ifndef HEADLESS
 	SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &maj);
 	SDL_GL_GetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, &min);
 	SDL_Log("Context     : %d.%d\n", maj, min);
+#endif
 
 	glGetIntegerv(GL_MAJOR_VERSION, &maj);
 	glGetIntegerv(GL_MINOR_VERSION, &min);
@@ -95,6 +265,7 @@ void GLManager::printInfo() {
 
 	GLint value = 0;
 
+#ifndef HEADLESS
 	SDL_GL_GetAttribute(SDL_GL_RED_SIZE, &value);
 	SDL_Log("SDL_GL_RED_SIZE: requested 8, got %d\n", value);
 	SDL_GL_GetAttribute(SDL_GL_GREEN_SIZE, &value);
@@ -107,6 +278,7 @@ void GLManager::printInfo() {
 	SDL_Log("SDL_GL_DEPTH_SIZE: requested 24, got %d\n", value);
 
 	SDL_Log("\n");
+#endif
 
 	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &value);
 	SDL_Log("Maximum number of vertex attributes supported: %d\n", value);
@@ -0,0 +1,305 @@
+#include "managers/lightManager.hpp"
+
+#include "components/lightComponent.hpp"
+#include "opengl/frameSync.hpp"
+#include "opengl/glState.hpp"
+#include "opengl/shader.hpp"
+#include "profiler.hpp"
+#include "third_party/Eigen/Dense"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Mirrors Light in assets/shaders/lighting.glsl with the std140 layout
+struct LightData {
+	Eigen::Vector3f position;
+	float range;
+	Eigen::Vector3f direction;
+	float cutOff;
+	Eigen::Vector3f color;
+	float outerCutOff;
+	Eigen::Vector3f attenuation;
+	float padding0;
+};
+static_assert(sizeof(LightData) == 64);
+static_assert(LightManager::BLOCK_SIZE == LightManager::MAX_LIGHTS * sizeof(LightData));
+// The hits and the index texture have 8 bits for the light
+static_assert(LightManager::MAX_LIGHTS <= 256);
+// Rows are tested four clusters at a time
+static_assert(LightManager::CLUSTERS_X % 4 == 0);
+
+static constexpr unsigned int INDEX_ROWS = LightManager::MAX_INDICES / LightManager::INDEX_WIDTH;
+
+LightManager::LightManager()
+	: mBoundsFor(Eigen::Vector4f::Zero()), mSlicing(Eigen::Vector2f::Zero()),
+	  mCounts(CLUSTERS, 0), mGrid(CLUSTERS * 2, 0), mIndices(MAX_INDICES, 0), mBlock(BLOCK_SIZE, 0),
+	  mGridTextures{}, mIndexTextures{}, mStats{}, mDropped(false) {
+	for (Eigen::ArrayXf& bounds : mBounds) {
+		bounds.setZero(CLUSTERS);
+	}
+
+	// Integer textures can only be sampled with nearest filtering
+	const auto create = [](GLuint& texture, GLenum format, GLsizei width, GLsizei height) {
+		glGenTextures(1, &texture);
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		if (format == GL_RG32UI) {
+			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RG_INTEGER,
+						 GL_UNSIGNED_INT, nullptr);
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RED_INTEGER,
+						 GL_UNSIGNED_BYTE, nullptr);
+		}
+	};
+
+	for (unsigned int frame = 0; frame < FrameSync::FRAMES; frame++) {
+		create(mGridTextures[frame], GL_RG32UI, CLUSTERS_X, CLUSTERS_Y * CLUSTERS_Z);
+		create(mIndexTextures[frame], GL_R8UI, INDEX_WIDTH, INDEX_ROWS);
+	}
+}
+
+LightManager::~LightManager() {
+	for (unsigned int frame = 0; frame < FrameSync::FRAMES; frame++) {
+		GLState::deleteTexture(mGridTextures[frame]);
+		GLState::deleteTexture(mIndexTextures[frame]);
+	}
+}
+
+void LightManager::add(LightComponent* light) { mLights.emplace_back(light); }
+
+void LightManager::remove(LightComponent* light) {
+	auto iter = std::find(mLights.begin(), mLights.end(), light);
+	if (iter != mLights.end()) {
+		mLights.erase(iter);
+	}
+}
+
+void LightManager::bounds(const Eigen::Matrix4f& projection, float near, float far) {
+	const Eigen::Vector4f key(projection(0, 0), projection(1, 1), near, far);
+	if (key.isApprox(mBoundsFor, 1.0e-6f)) {
+		return;
+	}
+	mBoundsFor = key;
+
+	mSlicing.x() = CLUSTERS_Z / std::log(far / near);
+	mSlicing.y() = -std::log(near) * mSlicing.x();
+
+	// The sides of a cluster are planes through the eye, so the box is spanned by the corners at
+	// the front and back of the slice
+	for (unsigned int z = 0; z < CLUSTERS_Z; z++) {
+		const float front = near * std::pow(far / near, static_cast<float>(z) / CLUSTERS_Z);
+		const float back = near * std::pow(far / near, static_cast<float>(z + 1) / CLUSTERS_Z);
+
+		for (unsigned int y = 0; y < CLUSTERS_Y; y++) {
+			const float bottom = (-1.0f + 2.0f * y / CLUSTERS_Y) / projection(1, 1);
+			const float top = (-1.0f + 2.0f * (y + 1) / CLUSTERS_Y) / projection(1, 1);
+
+			for (unsigned int x = 0; x < CLUSTERS_X; x++) {
+				const float left = (-1.0f + 2.0f * x / CLUSTERS_X) / projection(0, 0);
+				const float right = (-1.0f + 2.0f * (x + 1) / CLUSTERS_X) / projection(0, 0);
+
+				const unsigned int cluster = (z * CLUSTERS_Y + y) * CLUSTERS_X + x;
+				mBounds[0][cluster] = std::min(left * front, left * back);
+				mBounds[1][cluster] = std::min(bottom * front, bottom * back);
+				mBounds[2][cluster] = -back;
+				mBounds[3][cluster] = std::max(right * front, right * back);
+				mBounds[4][cluster] = std::max(top * front, top * back);
+				mBounds[5][cluster] = -front;
+			}
+		}
+	}
+}
+
+void LightManager::update(const Eigen::Affine3f& view, const Eigen::Matrix4f& projection,
+						  float near, float far) {
+	PROFILE_SCOPE("LightManager::update");
+
+	bounds(projection, near, far);
+
+	mHits.clear();
+	mVisible.clear();
+	std::fill(mCounts.begin(), mCounts.end(), 0);
+
+	const auto slice = [this](float depth) {
+		return std::clamp(static_cast<int>(std::log(depth) * mSlicing.x() + mSlicing.y()), 0,
+						  static_cast<int>(CLUSTERS_Z) - 1);
+	};
+
+	// Tiles covered by the view space box from low to high between the depths, the projection of
+	// a box is the widest at its corners
+	const auto tiles = [](float low, float high, float front, float back, float scale,
+						  unsigned int count, int& first, int& last) {
+		const float from = low * scale / (low < 0.0f ? front : back);
+		const float to = high * scale / (high > 0.0f ? front : back);
+
+		first = std::max(static_cast<int>(std::floor((from + 1.0f) / 2.0f * count)), 0);
+		last = std::min(static_cast<int>(std::floor((to + 1.0f) / 2.0f * count)),
+						static_cast<int>(count) - 1);
+
+		return first <= last;
+	};
+
+	for (const LightComponent* light : mLights) {
+		if (!light->isEnabled() || light->getRange() <= 0.0f) {
+			continue;
+		}
+
+		[[unlikely]] if (mVisible.size() == MAX_LIGHTS) {
+			if (!mDropped) {
+				SDL_Log("More than %u lights in view, the rest are dropped", MAX_LIGHTS);
+				mDropped = true;
+			}
+
+			break;
+		}
+
+		// Bounding sphere, of the cone for spot lights
+		Eigen::Vector3f center = light->getPosition();
+		float radius = light->getRange();
+
+		const float cosine = light->getOuterCutOff();
+		if (light->isSpot() && cosine > 0.0f) {
+			if (cosine < std::sqrt(0.5f)) {
+				center += light->getDirection() * radius * cosine;
+				radius *= std::sqrt(1.0f - cosine * cosine);
+			} else {
+				radius /= 2.0f * cosine;
+				center += light->getDirection() * radius;
+			}
+		}
+
+		center = view * center;
+
+		const float front = std::max(-(center.z() + radius), near);
+		const float back = std::min(-(center.z() - radius), far);
+		if (front > back) {
+			continue;
+		}
+
+		int x0 = 0, x1 = 0, y0 = 0, y1 = 0;
+		if (!tiles(center.x() - radius, center.x() + radius, front, back, projection(0, 0),
+				   CLUSTERS_X, x0, x1) ||
+			!tiles(center.y() - radius, center.y() + radius, front, back, projection(1, 1),
+				   CLUSTERS_Y, y0, y1)) {
+			continue;
+		}
+
+		const uint32_t index = static_cast<uint32_t>(mVisible.size());
+		const float radiusSquared = radius * radius;
+		bool hit = false;
+
+		// Sphere against the boxes of four clusters of a row at a time
+		for (int z = slice(front); z <= slice(back); z++) {
+			for (int y = y0; y <= y1; y++) {
+				const int row = (z * CLUSTERS_Y + y) * CLUSTERS_X;
+
+				for (int x = x0 & ~3; x <= x1; x += 4) {
+					const int first = row + x;
+					const auto distance = [this, first](unsigned int axis, float point) {
+						const Eigen::Map<const Eigen::Array4f> low(&mBounds[axis][first]);
+						const Eigen::Map<const Eigen::Array4f> high(&mBounds[axis + 3][first]);
+
+						return ((low - point).max(0.0f) + (point - high).max(0.0f)).square().eval();
+					};
+
+					const Eigen::Array4f squared = distance(0, center.x()) +
+												   distance(1, center.y()) +
+												   distance(2, center.z());
+
+					for (int lane = 0; lane < 4; lane++) {
+						if (squared[lane] <= radiusSquared && x + lane >= x0 && x + lane <= x1) {
+							const uint32_t cluster = static_cast<uint32_t>(first + lane);
+
+							mHits.emplace_back(cluster << 8 | index);
+							mCounts[cluster]++;
+							hit = true;
+						}
+					}
+				}
+			}
+		}
+
+		if (hit) {
+			mVisible.emplace_back(light);
+		}
+	}
+
+	// Counting sort by cluster, the lights of a cluster stay in order
+	uint32_t offset = 0;
+	unsigned int busiest = 0;
+	for (unsigned int cluster = 0; cluster < CLUSTERS; cluster++) {
+		const uint32_t count = mCounts[cluster];
+		const uint32_t first = std::min(offset, MAX_INDICES);
+
+		mGrid[cluster * 2] = first;
+		mGrid[cluster * 2 + 1] = std::min(offset + count, MAX_INDICES) - first;
+
+		mCounts[cluster] = offset;
+		offset += count;
+		busiest = std::max(busiest, count);
+	}
+
+	[[unlikely]] if (offset > MAX_INDICES && !mDropped) {
+		SDL_Log("More than %u light indices, the lights of the last clusters are dropped",
+				MAX_INDICES);
+		mDropped = true;
+	}
+
+	for (const uint32_t hit : mHits) {
+		const uint32_t position = mCounts[hit >> 8]++;
+		if (position < MAX_INDICES) {
+			mIndices[position] = static_cast<uint8_t>(hit & 0xFF);
+		}
+	}
+
+	mStats = {static_cast<unsigned int>(mLights.size()), static_cast<unsigned int>(mVisible.size()),
+			  std::min(offset, MAX_INDICES), busiest};
+
+	// Packed now, the lights can move on while the frame is written
+	LightData* const lights = reinterpret_cast<LightData*>(mBlock.data());
+
+	for (size_t i = 0; i < mVisible.size(); i++) {
+		const LightComponent* light = mVisible[i];
+		LightData& data = lights[i];
+
+		data.position = light->getPosition();
+		data.range = light->getRange();
+		data.direction = light->getDirection();
+		data.color = light->getColor();
+		data.attenuation = light->getAttenuation();
+
+		// Point lights fade out below every cosine, so that they are lit from every direction
+		data.cutOff = light->getCutOff();
+		data.outerCutOff = light->isSpot() ? light->getOuterCutOff() : -2.0f;
+	}
+}
+
+void LightManager::write(void* block) const {
+	std::memcpy(block, mBlock.data(), mStats.visible * sizeof(LightData));
+}
+
+void LightManager::bind() {
+	const unsigned int frame = FrameSync::getFrame();
+
+	// The textures of this frame are done being read, the fence of its slot was waited for
+	GLState::bindTexture(Shader::LIGHT_GRID_UNIT, GL_TEXTURE_2D, mGridTextures[frame]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, CLUSTERS_X, CLUSTERS_Y * CLUSTERS_Z, GL_RG_INTEGER,
+					GL_UNSIGNED_INT, mGrid.data());
+
+	GLState::bindTexture(Shader::LIGHT_INDEX_UNIT, GL_TEXTURE_2D, mIndexTextures[frame]);
+	const unsigned int rows = (mStats.indices + INDEX_WIDTH - 1) / INDEX_WIDTH;
+	if (rows > 0) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, INDEX_WIDTH, static_cast<GLsizei>(rows),
+						GL_RED_INTEGER, GL_UNSIGNED_BYTE, mIndices.data());
+	}
+}
@@ -1,98 +1,228 @@
 #include "managers/shaderManager.hpp"
 
 #include "opengl/shader.hpp"
+#include "profiler.hpp"
 #include "utils.hpp"
 
 #include <SDL3/SDL.h>
+#include <algorithm>
 #include <assert.h>
 #include <stddef.h>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
-#ifdef DEBUG
-#include <filesystem>
+#ifdef EMBED_SHADERS
+#include "embeddedShaders.hpp"
+#endif
+
+#ifndef EMBED_SHADERS
+#ifdef GLES
+constexpr std::string_view SHADER_VERSION = "#version 300 es\n";
+#else
+constexpr std::string_view SHADER_VERSION = "#version 400 core\n";
+#endif
 #endif
 
 ShaderManager::ShaderManager(const std::string& path)
 	: mPath(path + "assets" + SEPARATOR + "shaders" + SEPARATOR) {}
 
-Shader* ShaderManager::get(const std::string& vert, const std::string& frag) {
+Shader* ShaderManager::get(const std::string& vert, const std::string& frag,
+						   const ShaderDefines& defines) {
 	assert(vert.find(':') == std::string::npos && frag.find(':') == std::string::npos);
 
-	if (mTextures.contains(vert + ':' + frag)) {
-		return mTextures.at(vert + ':' + frag);
+	const std::string name = key(vert, frag, defines);
+
+	if (mShaders.contains(name)) {
+		return mShaders.at(name).shader;
+	}
+
+	Permutation permutation = {vert, frag, defines, nullptr};
+	permutation.shader = compile(permutation, name);
+
+	return mShaders.emplace(name, std::move(permutation)).first->second.shader;
+}
+
+// vert:frag, followed by :NAME=VALUE for every define
+std::string ShaderManager::key(const std::string& vert, const std::string& frag,
+							   const ShaderDefines& defines) {
+	std::string name = vert + ':' + frag;
+
+	for (const auto& [define, value] : defines) {
+		name += ':' + define + '=' + value;
+	}
+
+	return name;
+}
+
+Shader* ShaderManager::compile(const Permutation& permutation, const std::string& name) {
+	PROFILE_SCOPE("ShaderManager::compile");
+
+	std::vector<std::string> files;
+
+	const std::string vertSource = source(permutation.vert, files);
+	const std::string fragSource = source(permutation.frag, files);
+
+	std::string defines;
+	for (const auto& [define, value] : permutation.defines) {
+		defines += "#define " + define + ' ' + value + '\n';
 	}
 
-	Shader* shader = new Shader(mPath + vert, mPath + frag);
-	mTextures[vert + ':' + frag] = shader;
+	Shader* shader = new Shader(permutation.vert, vertSource, permutation.frag, fragSource, defines);
 
 #ifdef DEBUG
-	mLastEdit[shader] = std::max(std::filesystem::last_write_time(mPath + vert),
-								 std::filesystem::last_write_time(mPath + frag));
+	mFiles[name] = std::move(files);
+#else
+	(void)name;
 #endif
 
 	return shader;
 }
 
-// TODO: Unloading when out of memory
+std::string ShaderManager::source(const std::string& name, std::vector<std::string>& files) const {
+#ifdef EMBED_SHADERS
+	(void)files;
 
-ShaderManager::~ShaderManager() {
-	for (const auto& [_, shader] : mTextures) {
-		delete shader;
+	const auto shader =
+		std::find_if(EMBEDDED_SHADERS.begin(), EMBEDDED_SHADERS.end(),
+					 [&name](const auto& embedded) { return embedded.first == name; });
+
+	[[unlikely]] if (shader == EMBEDDED_SHADERS.end()) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Shader %s isn't embedded\n", name.data());
+		ERROR_BOX("Failed to read assets");
+
+		throw std::runtime_error("shaderManager.cpp: Failed to find shader source");
 	}
+
+	return std::string(shader->second);
+#else
+	std::string out(SHADER_VERSION);
+	std::vector<std::string> included;
+
+	preprocess(name, out, included);
+
+	files.insert(files.end(), included.begin(), included.end());
+
+	return out;
+#endif
 }
 
-void ShaderManager::reload(bool full) {
-	SDL_Log("Reloading shaders");
+#ifndef EMBED_SHADERS
+// Same as cmake/embed-shaders.cmake: resolve includes once and drop the #version line
+void ShaderManager::preprocess(const std::string& name, std::string& out,
+							   std::vector<std::string>& files) const {
+	const std::string path = mPath + name;
 
-	for (auto& [names, shader] : mTextures) {
-		const size_t pos = names.find(':');
-		std::string vert = mPath + names.substr(0, pos);
-		std::string frag = mPath + names.substr(pos + 1, names.size() - pos);
+	char* data = static_cast<char*>(SDL_LoadFile(path.data(), nullptr));
+	[[unlikely]] if (data == nullptr) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to read shader shource %s: %s\n",
+						path.data(), SDL_GetError());
 
-#ifdef DEBUG
-		SDL_Log("Reloading %s:%s", vert.data(), frag.data());
+#ifndef DEBUG
+		ERROR_BOX("Failed to read assets");
+#endif
 
-		// TODO: Some wierd vim write stuff
-		// FIXME: I don't fucking know why this doesn't work
-		std::filesystem::file_time_type lastEditTime;
-		try {
-			lastEditTime = std::max(std::filesystem::last_write_time(vert),
-										   std::filesystem::last_write_time(frag));
-		} catch (std::filesystem::filesystem_error) {
-			continue;
+		throw std::runtime_error("shaderManager.cpp: Failed to read shader source");
+	}
+
+	const std::string text(data);
+	SDL_free(data);
+
+	files.emplace_back(path);
+
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos) {
+			end = text.size();
 		}
 
-		if (!full && lastEditTime == mLastEdit[shader]) {
+		const std::string_view line = std::string_view(text).substr(start, end - start);
+		start = end + 1;
+
+		if (line.starts_with("#version")) {
 			continue;
 		}
 
-		try {
-			Shader* newTexture = new Shader(vert, frag);
+		if (line.starts_with("#include")) {
+			const size_t first = line.find('"');
+			const size_t last = line.rfind('"');
 
-			delete shader;
+			[[unlikely]] if (first == std::string_view::npos || first == last) {
+				SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Malformed include in %s\n", path.data());
 
-			shader = newTexture;
-		} catch (std::runtime_error error) {
-			SDL_Log("Error recompiling shaders: %s", error.what());
+				throw std::runtime_error("shaderManager.cpp: Malformed include");
+			}
 
-			shader = this->get("default.vert", "default.frag");
+			const std::string file(line.substr(first + 1, last - first - 1));
+			if (std::find(files.begin(), files.end(), mPath + file) == files.end()) {
+				preprocess(file, out, files);
+			}
+
+			continue;
 		}
 
-		/*
-		mLastEdit[shader] = lastEditTime;
-		*/
-		(void) full;
+		out += line;
+		out += '\n';
+	}
+}
+#endif
+
+// TODO: Unloading when out of memory
+
+ShaderManager::~ShaderManager() {
+	for (const auto& [_, permutation] : mShaders) {
+		delete permutation.shader;
+	}
+}
+
+void ShaderManager::reload() {
+	SDL_Log("Reloading shaders");
+
+	for (auto& [names, permutation] : mShaders) {
+#ifdef DEBUG
+		recompile(names, permutation);
 #else
+		Shader*& shader = permutation.shader;
+
 		try {
 			delete shader;
-			Shader* newTexture = new Shader(vert, frag);
-			shader = newTexture;
-		} catch (std::runtime_error error) {
+			Shader* newShader = compile(permutation, names);
+			shader = newShader;
+		} catch (const std::runtime_error& error) {
 			shader = this->get("default.vert", "default.frag");
 			throw error;
 		}
 #endif
 	}
 }
+
+#ifdef DEBUG
+// Only rebuild the permutations built from the file, includes too
+void ShaderManager::reload(const std::string& file) {
+	for (auto& [names, permutation] : mShaders) {
+		const std::vector<std::string>& files = mFiles[names];
+
+		if (std::find(files.begin(), files.end(), mPath + file) != files.end()) {
+			recompile(names, permutation);
+		}
+	}
+}
+
+void ShaderManager::recompile(const std::string& name, Permutation& permutation) {
+	SDL_Log("Reloading %s", name.data());
+
+	try {
+		Shader* shader = compile(permutation, name);
+
+		delete permutation.shader;
+
+		permutation.shader = shader;
+	} catch (const std::runtime_error& error) {
+		// Keep the old shader until the files are touched again
+		SDL_Log("Error recompiling shaders: %s", error.what());
+	}
+}
+#endif
@@ -4,11 +4,11 @@
 #include "opengl/cubemap.hpp"
 #include "utils.hpp"
 
-#include <unordered_map>
-
-#ifdef DEBUG
+#include <SDL3/SDL.h>
 #include <filesystem>
-#endif
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 
 TextureManager::TextureManager(const std::string& path)
 	: mPath(path + "assets" + SEPARATOR + "textures" + SEPARATOR) {}
@@ -18,7 +18,10 @@ Texture* TextureManager::get(const std::string& name) {
 		return mTextures.at(name);
 	}
 
-	Texture* texture = new Cubemap(name + SEPARATOR);
+	// Names are either relative to assets/textures or a path
+	const std::string path = std::filesystem::exists(mPath + name) ? mPath + name : name;
+
+	Texture* texture = new Cubemap(path + SEPARATOR);
 	/*
 	if (!name.contains('.')) {
 		texture = new Cubemap(name + SEPARATOR);
@@ -31,10 +34,6 @@ Texture* TextureManager::get(const std::string& name) {
 
 	mTextures[name] = texture;
 
-#ifdef DEBUG
-	mLastEdit[texture] = std::filesystem::last_write_time(mPath + name);
-#endif
-
 	return texture;
 }
 
@@ -46,20 +45,26 @@ TextureManager::~TextureManager() {
 	}
 }
 
-void TextureManager::reload(bool full) {
-	for (auto& [name, texture] : mTextures) {
-#ifdef DEBUG
-		if (!full && std::filesystem::last_write_time(mPath + name) == mLastEdit[texture]) {
+void TextureManager::reload() {
+	for (const auto& [_, texture] : mTextures) {
+		texture->reload();
+	}
+}
+
+void TextureManager::reload(const std::string& file) {
+	const std::filesystem::path path =
+		std::filesystem::path(mPath + file).lexically_normal().parent_path();
+
+	for (const auto& [name, texture] : mTextures) {
+		// Cubemaps are loaded from a directory
+		if (std::filesystem::path(texture->getPath()).lexically_normal().parent_path() != path) {
 			continue;
 		}
-#endif
 
-		delete texture;
-		auto* newTexture = new Texture(mPath + name);
-		texture = newTexture;
-
-#ifdef DEBUG
-		mLastEdit[texture] = std::filesystem::last_write_time(mPath + name);
-#endif
+		try {
+			texture->reload();
+		} catch (const std::runtime_error& error) {
+			SDL_Log("Error reloading texture %s: %s", name.data(), error.what());
+		}
 	}
 }
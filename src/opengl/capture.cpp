@@ -0,0 +1,319 @@
+#include "opengl/capture.hpp"
+
+#include "opengl/glState.hpp"
+#include "profiler.hpp"
+#include "third_party/glad/glad.h"
+#include "utils.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Frames waiting for the writer before the render thread waits too, bounds the memory
+static constexpr size_t MAX_QUEUED = 8;
+static constexpr GLuint64 FENCE_TIMEOUT = 1000000000;
+
+Capture::Capture(const std::string& directory, Format format, unsigned int fps)
+	: mDirectory(directory), mFormat(format), mFPS(fps), mSlots{}, mNext(0), mRunning(true),
+	  mFile(nullptr), mWritten(0), mStreamWidth(0), mStreamHeight(0) {
+	for (Slot& slot : mSlots) {
+		glGenBuffers(1, &slot.buffer);
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(mDirectory, error);
+
+	SDL_Log("Capturing to %s", mDirectory.data());
+
+	mThread = std::thread(&Capture::run, this);
+}
+
+Capture::~Capture() {
+	// Oldest first, the frames have to stay in order
+	for (unsigned int i = 0; i < BUFFERS; i++) {
+		read(mSlots[(mNext + i) % BUFFERS]);
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+	mCondition.notify_all();
+
+	mThread.join();
+
+	for (const Slot& slot : mSlots) {
+		glDeleteBuffers(1, &slot.buffer);
+	}
+
+	if (mFile != nullptr) {
+		SDL_CloseIO(mFile);
+	}
+
+	SDL_Log("Captured %u frames", mWritten);
+}
+
+bool Capture::parseFormat(const std::string& name, Format& format) {
+	if (name == "ppm") {
+		format = PPM;
+	} else if (name == "y4m") {
+		format = Y4M;
+	} else if (name == "raw") {
+		format = RAW;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+void Capture::capture(GLuint framebuffer, int width, int height) {
+	Slot& slot = mSlots[mNext];
+	mNext = (mNext + 1) % BUFFERS;
+
+	// Read BUFFERS frames ago, the GPU is usually long done with it
+	read(slot);
+
+	const GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if (size > slot.size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.size = size;
+	}
+
+	// Into the bound buffer, returns right away. GLES only guarantees RGBA reads
+	GLState::bindFramebuffer(framebuffer);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.width = width;
+	slot.height = height;
+}
+
+void Capture::read(Slot& slot) {
+	if (slot.fence == nullptr) {
+		return;
+	}
+
+	PROFILE_SCOPE("Capture::read");
+
+	GLenum status = GL_TIMEOUT_EXPIRED;
+	while (status == GL_TIMEOUT_EXPIRED) {
+		status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	[[unlikely]] if (status == GL_WAIT_FAILED) {
+		SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Failed to wait for a captured frame\n");
+
+		return;
+	}
+
+	const size_t size = static_cast<size_t>(slot.width) * slot.height * 4;
+
+	Frame frame = {slot.width, slot.height, {}};
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		if (!mFree.empty()) {
+			frame.pixels = std::move(mFree.back());
+			mFree.pop_back();
+		}
+	}
+	frame.pixels.resize(size);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+										GL_MAP_READ_BIT);
+	if (data != nullptr) {
+		std::memcpy(frame.pixels.data(), data, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	[[unlikely]] if (data == nullptr) {
+		SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Failed to map a captured frame\n");
+
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCondition.wait(lock, [this] { return mFrames.size() < MAX_QUEUED; });
+
+	mFrames.emplace_back(std::move(frame));
+	mCondition.notify_all();
+}
+
+void Capture::run() {
+	PROFILE_THREAD("Capture");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while (true) {
+		mCondition.wait(lock, [this] { return !mFrames.empty() || !mRunning; });
+
+		// Only stops once everything is written
+		if (mFrames.empty()) {
+			break;
+		}
+
+		Frame frame = std::move(mFrames.front());
+		mFrames.pop_front();
+		mCondition.notify_all();
+
+		lock.unlock();
+		write(frame);
+		lock.lock();
+
+		mFree.emplace_back(std::move(frame.pixels));
+	}
+}
+
+void Capture::write(const Frame& frame) {
+	PROFILE_SCOPE("Capture::write");
+
+	const int width = frame.width;
+	const int height = frame.height;
+
+	// Every format starts at the top row
+	const auto pixel = [&frame, width, height](int x, int y) {
+		return frame.pixels.data() + (static_cast<size_t>(height - 1 - y) * width + x) * 4;
+	};
+
+	if (mFormat == PPM) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "frame%05u.ppm", mWritten);
+
+		const std::string header =
+			"P6\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n255\n";
+
+		mConverted.resize(header.size() + static_cast<size_t>(width) * height * 3);
+		std::memcpy(mConverted.data(), header.data(), header.size());
+
+		unsigned char* out = mConverted.data() + header.size();
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				std::memcpy(out, pixel(x, y), 3);
+				out += 3;
+			}
+		}
+
+		const std::string path = mDirectory + SEPARATOR + name;
+		if (!SDL_SaveFile(path.data(), mConverted.data(), mConverted.size())) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write %s: %s\n", path.data(),
+						 SDL_GetError());
+		}
+
+		mWritten++;
+
+		return;
+	}
+
+	// The streams have a single size, set by the first frame
+	if (mFile == nullptr) {
+		const std::string path =
+			mDirectory + SEPARATOR + (mFormat == Y4M ? "capture.y4m" : "capture.rgb");
+
+		mFile = SDL_IOFromFile(path.data(), "wb");
+		[[unlikely]] if (mFile == nullptr) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open %s: %s\n", path.data(),
+						 SDL_GetError());
+
+			return;
+		}
+
+		mStreamWidth = width;
+		mStreamHeight = height;
+
+		if (mFormat == Y4M) {
+			// Full range BT.601 4:2:0, which is what the conversion below produces
+			const std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" +
+									   std::to_string(height) + " F" + std::to_string(mFPS) +
+									   ":1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+			SDL_WriteIO(mFile, header.data(), header.size());
+		} else {
+			SDL_Log("Raw capture is %dx%d RGB24", width, height);
+		}
+	}
+
+	if (width != mStreamWidth || height != mStreamHeight) {
+		SDL_Log("Dropped a %dx%d frame from the %dx%d capture", width, height, mStreamWidth,
+				mStreamHeight);
+
+		return;
+	}
+
+	if (mFormat == RAW) {
+		mConverted.resize(static_cast<size_t>(width) * height * 3);
+
+		unsigned char* out = mConverted.data();
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				std::memcpy(out, pixel(x, y), 3);
+				out += 3;
+			}
+		}
+	} else {
+		const int chromaWidth = (width + 1) / 2;
+		const int chromaHeight = (height + 1) / 2;
+
+		static const char FRAME[] = "FRAME\n";
+
+		const size_t luma = static_cast<size_t>(width) * height;
+		const size_t chroma = static_cast<size_t>(chromaWidth) * chromaHeight;
+		mConverted.resize(sizeof(FRAME) - 1 + luma + chroma * 2);
+		std::memcpy(mConverted.data(), FRAME, sizeof(FRAME) - 1);
+
+		unsigned char* y = mConverted.data() + sizeof(FRAME) - 1;
+		unsigned char* u = y + luma;
+		unsigned char* v = u + chroma;
+
+		for (int row = 0; row < height; row++) {
+			for (int x = 0; x < width; x++) {
+				const unsigned char* p = pixel(x, row);
+
+				*y++ = static_cast<unsigned char>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+			}
+		}
+
+		// Chroma from the average of every 2x2 block, edges repeat the last row and column
+		for (int row = 0; row < chromaHeight; row++) {
+			for (int x = 0; x < chromaWidth; x++) {
+				int r = 0;
+				int g = 0;
+				int b = 0;
+
+				for (int i = 0; i < 4; i++) {
+					const unsigned char* p = pixel(std::min(x * 2 + (i & 1), width - 1),
+												   std::min(row * 2 + (i >> 1), height - 1));
+					r += p[0];
+					g += p[1];
+					b += p[2];
+				}
+
+				// Pure blue and red round up to 256
+				*u++ = static_cast<unsigned char>(
+					std::min(((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128, 255));
+				*v++ = static_cast<unsigned char>(
+					std::min(((128 * r - 107 * g - 21 * b + 512) >> 10) + 128, 255));
+			}
+		}
+	}
+
+	if (SDL_WriteIO(mFile, mConverted.data(), mConverted.size()) != mConverted.size()) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write a frame: %s\n", SDL_GetError());
+	}
+
+	mWritten++;
+}
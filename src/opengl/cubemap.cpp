@@ -1,5 +1,7 @@
 #include "opengl/cubemap.hpp"
 
+#include "opengl/glState.hpp"
+#include "profiler.hpp"
 #include "third_party/stb_image.h"
 #include "utils.hpp"
 
@@ -11,15 +13,16 @@
 Cubemap::Cubemap(const std::string_view& path) : Texture(path) {}
 
 void Cubemap::activate(const unsigned int& num) const {
-	glActiveTexture(GL_TEXTURE0 + num);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, mID);
+	GLState::bindTexture(num, GL_TEXTURE_CUBE_MAP, mID);
 }
 
 void Cubemap::load() {
+	PROFILE_SCOPE("Cubemap::load");
+
 	SDL_Log("Loading cubemap %s", name.data());
 
 	glGenTextures(1, &mID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, mID);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, mID);
 
 	const std::vector faces0 = {"right.png",  "left.png",  "top.png",
 								"bottom.png", "front.png", "back.png"};
@@ -0,0 +1,81 @@
+#include "opengl/frameSync.hpp"
+
+#include "profiler.hpp"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+unsigned int FrameSync::mFrame = 0;
+unsigned int FrameSync::mFramesInFlight = FrameSync::FRAMES;
+bool FrameSync::mRunning = false;
+
+std::array<GLsync, FrameSync::FRAMES> FrameSync::mFences = {};
+std::array<std::vector<std::function<void()>>, FrameSync::FRAMES> FrameSync::mDeletes;
+
+void FrameSync::wait(unsigned int frame) {
+	GLsync& fence = mFences[frame];
+
+	if (fence != nullptr) {
+		PROFILE_SCOPE("FrameSync::wait");
+
+		// Only flush on the first try, after that the commands are on their way
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED) {
+			flags = 0;
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// Deletes can defer more deletes
+	std::vector<std::function<void()>> deletes = std::move(mDeletes[frame]);
+	mDeletes[frame].clear();
+
+	for (const auto& function : deletes) {
+		function();
+	}
+}
+
+void FrameSync::begin() {
+	mRunning = true;
+
+	mFrame = (mFrame + 1) % FRAMES;
+
+	// Oldest first, the slot of this frame is the frame FRAMES ago
+	for (unsigned int age = FRAMES; age >= mFramesInFlight; age--) {
+		wait((mFrame + FRAMES - age) % FRAMES);
+	}
+}
+
+void FrameSync::end() { mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); }
+
+void FrameSync::finish() {
+	mRunning = false;
+
+	// Oldest first
+	for (unsigned int i = 1; i <= FRAMES; i++) {
+		wait((mFrame + i) % FRAMES);
+	}
+}
+
+void FrameSync::setFramesInFlight(unsigned int frames) {
+	mFramesInFlight = std::clamp(frames, 1u, FRAMES);
+}
+
+void FrameSync::defer(std::function<void()> function) {
+	if (!mRunning) {
+		function();
+
+		return;
+	}
+
+	// The fence of the current frame comes after everything submitted until now
+	mDeletes[mFrame].emplace_back(std::move(function));
+}
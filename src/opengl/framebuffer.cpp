@@ -1,15 +1,23 @@
 #include "opengl/framebuffer.hpp"
 
 #include "game.hpp"
+#include "managers/glManager.hpp"
+#include "opengl/glState.hpp"
+#include "opengl/gpuProfiler.hpp"
 #include "opengl/mesh.hpp"
+#include "opengl/renderGraph.hpp"
 #include "opengl/shader.hpp"
 #include "opengl/texture.hpp"
+#include "profiler.hpp"
 #include "third_party/glad/glad.h"
 #include "utils.hpp"
 
 #include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <stdexcept>
+#include <string>
 
 #ifdef IMGUI
 #include <backends/imgui_impl_opengl3.h>
@@ -17,16 +25,46 @@
 #include <imgui.h>
 #endif
 
-Framebuffer::Framebuffer(Game* owner) : mOwner(owner), mRBO(0), mScreen(0), mScreenTexture(0) {
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+// The scale moves in steps, so that small changes in the GPU time don't resize every frame
+static constexpr float SCALE_STEP = 0.05f;
+// Part of the budget the scene is scaled to, the rest is left for the upscale, ImGui and noise
+static constexpr float HEADROOM = 0.85f;
+static constexpr unsigned int COOLDOWN = 30;
+
+Framebuffer::Framebuffer(Game* owner)
+	: mOwner(owner), mWidth(1024), mHeight(768), mScale(1.0f), mBudget(1000.0f / 60.0f),
+	  mGPUTime(0.0f), mDynamic(false), mCooldown(0), mQueries{}, mFirstQuery(0),
+	  mPendingQueries(0), mTiming(false), mGetQueryObject(nullptr), mRBO(0), mScreen(0),
+	  mScreenTexture(0), mGraph(nullptr), mBlit{}, mCapture(nullptr), mCaptureDynamic(false) {
+#ifdef GLES
+	if (GLManager::extensionSupported("GL_EXT_disjoint_timer_query")) {
+		mGetQueryObject = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(
+			GLManager::getProcAddress("glGetQueryObjectui64vEXT"));
+	}
+#else
+	mGetQueryObject = glGetQueryObjectui64v;
+#endif
+
+	if (mGetQueryObject != nullptr) {
+		glGenQueries(QUERIES, mQueries.data());
+		mDynamic = true;
+	} else {
+		SDL_Log("No timer queries, dynamic resolution is disabled");
+	}
+
 	glGenFramebuffers(1, &mScreen);
-	glBindFramebuffer(GL_FRAMEBUFFER, mScreen);
+	GLState::bindFramebuffer(mScreen);
 
 	glGenTextures(1, &mScreenTexture);
-	glBindTexture(GL_TEXTURE_2D, mScreenTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, mScreenTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1024, 768, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
 
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mScreenTexture, 0);
 
@@ -43,7 +81,7 @@ Framebuffer::Framebuffer(Game* owner) : mOwner(owner), mRBO(0), mScreen(0), mScr
 		throw std::runtime_error("Framebuffer.cpp: Failed to create framebuffer");
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mScreen);
+	GLState::bindFramebuffer(mScreen);
 
 	const std::vector<Vertex> vertices = {
 		{{-1.0f, +1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f}}, // Top left
@@ -55,54 +93,278 @@ Framebuffer::Framebuffer(Game* owner) : mOwner(owner), mRBO(0), mScreen(0), mScr
 	const std::vector<std::pair<Texture*, TextureType>> textures = {};
 
 	mScreenMesh = std::make_unique<Mesh>(vertices, indices, textures);
+
+	mGraph = std::make_unique<RenderGraph>(mOwner, mScreenMesh.get());
+	mBlit = {mScreen, mScreenTexture, {}, {}};
 }
 
 void Framebuffer::setDemensions(int width, int height) {
+	mWidth = width;
+	mHeight = height;
+
+	glBindRenderbuffer(GL_RENDERBUFFER, mRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
 
-	glBindTexture(GL_TEXTURE_2D, mScreenTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, mScreenTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Framebuffer::setDynamic(bool dynamic) {
+	// Without timer queries there is nothing to scale by
+	mDynamic = dynamic && mGetQueryObject != nullptr;
+
+	if (!mDynamic) {
+		mScale = 1.0f;
+	}
+}
+
+int Framebuffer::sceneWidth() const {
+	return std::max(static_cast<int>(std::lround(mWidth * mScale)), 1);
+}
+
+int Framebuffer::sceneHeight() const {
+	return std::max(static_cast<int>(std::lround(mHeight * mScale)), 1);
+}
+
+void Framebuffer::begin() {
+	// Before the viewport, the scale has to stay the same until swap
+	if (mGetQueryObject != nullptr) {
+		readQueries();
+	}
+
+	GLState::bindFramebuffer(mScreen);
+
+	// The targets stay at window size, the scene only renders into the scaled corner of them
+	glViewport(0, 0, sceneWidth(), sceneHeight());
+
+	// Every query is still in flight, this frame isn't timed
+	if (mGetQueryObject != nullptr && mPendingQueries < QUERIES) {
+		glBeginQuery(GL_TIME_ELAPSED, mQueries[(mFirstQuery + mPendingQueries) % QUERIES]);
+		mTiming = true;
+	}
+}
+
+void Framebuffer::readQueries() {
+#ifdef GLES
+	// The results are garbage after a disjoint operation like a power state change
+	GLint disjoint = 0;
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+#else
+	const GLint disjoint = 0;
+#endif
+
+	while (mPendingQueries > 0) {
+		const GLuint query = mQueries[mFirstQuery];
+
+		GLuint available = 0;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0) {
+			break;
+		}
+
+		GLuint64 time = 0;
+		mGetQueryObject(query, GL_QUERY_RESULT, &time);
+
+		mFirstQuery = (mFirstQuery + 1) % QUERIES;
+		mPendingQueries--;
+
+		if (disjoint == 0) {
+			updateScale(static_cast<float>(time) / 1000000.0f);
+		}
+	}
+}
+
+void Framebuffer::updateScale(float time) {
+	mGPUTime = mGPUTime <= 0.0f ? time : mGPUTime + (time - mGPUTime) * 0.1f;
+
+	if (mCooldown > 0) {
+		mCooldown--;
+
+		return;
+	}
+
+	if (!mDynamic || mGPUTime <= 0.0f) {
+		return;
+	}
+
+	// The cost is mostly fill rate, so it goes with the pixel count, the square of the scale
+	const float target = mScale * std::sqrt(mBudget * HEADROOM / mGPUTime);
+	const float scale = std::clamp(std::round(target / SCALE_STEP) * SCALE_STEP, MIN_SCALE, 1.0f);
+
+	if (std::abs(scale - mScale) < SCALE_STEP * 0.5f) {
+		return;
+	}
+
+	// Assume the new scale costs what the pixel count says until it is measured
+	mGPUTime *= (scale * scale) / (mScale * mScale);
+	mScale = scale;
+	mCooldown = COOLDOWN;
+}
+
+void Framebuffer::swap(SDL_Window* window, const Eigen::Matrix3f& reprojection) {
+	PROFILE_SCOPE("Framebuffer::swap");
+
+	if (mTiming) {
+		glEndQuery(GL_TIME_ELAPSED);
+		mPendingQueries++;
+		mTiming = false;
+	}
+
+	if (mCapture) {
+		const GPUProfiler::Scope capture("Capture");
+
+		mCapture->capture(mScreen, sceneWidth(), sceneHeight());
+	}
+
+	// The wireframe mode is set again every frame
+	GLState::polygonMode(GL_FILL);
+
+#ifndef HEADLESS
+	postProcess();
+#endif
+
+	present(window, reprojection);
 }
 
-void Framebuffer::swap(SDL_Window* window) {
-	int mode;
-	glGetIntegerv(GL_POLYGON_MODE, &mode);
+void Framebuffer::postProcess() {
+	mGraph->begin(mScreen, mScreenTexture, mWidth, mHeight, mScale);
 
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	RenderGraph::Resource color = RenderGraph::SCENE;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
-	glDisable(GL_DEPTH_TEST);
+	if (mEffects.blur > 0.0f) {
+		// Separable, across and then down
+		for (const Eigen::Vector2f& direction : {Eigen::Vector2f(1.0f, 0.0f),
+												 Eigen::Vector2f(0.0f, 1.0f)}) {
+			const RenderGraph::Resource blurred = mGraph->create();
+			// The taps reach four spacings out
+			const Eigen::Vector2f spacing = direction * (mEffects.blur / 4.0f);
 
-	Shader* mShader = mOwner->getShader("framebuffer.vert", "framebuffer.frag");
-	mShader->activate();
+			mGraph->addPass({"Blur", {color}, blurred, "blur.frag", "",
+							 [spacing](const Shader* shader) {
+								 shader->set("spacing", spacing.x(), spacing.y());
+							 }});
+			color = blurred;
+		}
+	}
 
-	mShader->set("screen", 0);
+	if (mEffects.sharpen > 0.0f) {
+		const RenderGraph::Resource sharpened = mGraph->create();
+		const float amount = mEffects.sharpen;
 
-	mShader->set("width", mOwner->getWidth());
-	mShader->set("height", mOwner->getHeight());
+		mGraph->addPass({"Sharpen", {color}, sharpened, "sharpen.frag", "",
+						 [amount](const Shader* shader) { shader->set("amount", amount); }});
+		color = sharpened;
+	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mScreenTexture);
+	// Per pixel, these end up in the final blit
+	if (std::abs(mEffects.exposure - 1.0f) > 0.001f) {
+		const RenderGraph::Resource exposed = mGraph->create();
+		const float exposure = mEffects.exposure;
 
-	mScreenMesh->draw(mShader);
+		mGraph->addPass({"Exposure", {color}, exposed, "framebuffer.frag", "EXPOSURE",
+						 [exposure](const Shader* shader) { shader->set("exposure", exposure); }});
+		color = exposed;
+	}
+
+	if (mEffects.vignette > 0.0f) {
+		const RenderGraph::Resource vignetted = mGraph->create();
+		const float vignette = mEffects.vignette;
+
+		mGraph->addPass({"Vignette", {color}, vignetted, "framebuffer.frag", "VIGNETTE",
+						 [vignette](const Shader* shader) { shader->set("vignette", vignette); }});
+		color = vignetted;
+	}
+
+	mBlit = mGraph->execute(color);
+}
+
+void Framebuffer::present(SDL_Window* window, const Eigen::Matrix3f& reprojection) {
+#ifdef HEADLESS
+	(void)window;
+	(void)reprojection;
+
+	// There is nothing to present to, captures read the framebuffer
+	glFlush();
+#else
+	{
+		const GPUProfiler::Scope present("Present");
+
+		GLState::bindFramebuffer(0);
+		glViewport(0, 0, mWidth, mHeight);
+		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		GLState::disable(GL_DEPTH_TEST);
+
+		if (mBlit.defines.empty() && reprojection.isIdentity()) {
+			// Nothing to do per pixel, so the fixed function upscale is enough
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, mBlit.framebuffer);
+			glBlitFramebuffer(0, 0, sceneWidth(), sceneHeight(), 0, 0, mWidth, mHeight,
+							  GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		} else {
+			const Shader* shader =
+				mOwner->getShader("framebuffer.vert", "framebuffer.frag", mBlit.defines);
+			shader->activate();
+
+			shader->set("screen", 0);
+			shader->set("scale", mScale);
+			shader->set("reprojection", reprojection);
+			for (const auto& uniforms : mBlit.uniforms) {
+				uniforms(shader);
+			}
+
+			GLState::bindTexture(0, GL_TEXTURE_2D, mBlit.texture);
+
+			mScreenMesh->bind();
+			mScreenMesh->draw();
+		}
 
 #ifdef IMGUI
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		{
+			const GPUProfiler::Scope imgui("ImGui");
+
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
 #endif
+	}
 
 	SDL_GL_SwapWindow(window);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mScreen);
-	glEnable(GL_DEPTH_TEST);
+	GLState::bindFramebuffer(mScreen);
+	GLState::enable(GL_DEPTH_TEST);
+#endif
+}
 
-	glPolygonMode(GL_FRONT_AND_BACK, mode);
+void Framebuffer::startCapture(const std::string& directory, Capture::Format format,
+							   unsigned int fps) {
+	if (mCapture) {
+		return;
+	}
+
+	// A changing resolution would change the size of the frames
+	mCaptureDynamic = mDynamic;
+	setDynamic(false);
+
+	mCapture = std::make_unique<Capture>(directory, format, fps);
+}
+
+void Framebuffer::stopCapture() {
+	if (!mCapture) {
+		return;
+	}
+
+	mCapture = nullptr;
+
+	setDynamic(mCaptureDynamic);
 }
 
 Framebuffer::~Framebuffer() {
-	glDeleteTextures(1, &mScreenTexture);
-	glDeleteFramebuffers(1, &mScreen);
+	if (mGetQueryObject != nullptr) {
+		glDeleteQueries(QUERIES, mQueries.data());
+	}
+
+	GLState::deleteTexture(mScreenTexture);
+	GLState::deleteFramebuffer(mScreen);
 	glDeleteRenderbuffers(1, &mRBO);
 }
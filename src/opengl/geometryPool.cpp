@@ -0,0 +1,257 @@
+#include "opengl/geometryPool.hpp"
+
+#include "managers/glManager.hpp"
+#include "opengl/frameSync.hpp"
+#include "opengl/glState.hpp"
+#include "opengl/types.hpp"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+GeometryPool* GeometryPool::mInstance = nullptr;
+
+// In elements, doubled when full
+static constexpr GLuint INITIAL_VERTICES = 1 << 16;
+static constexpr GLuint INITIAL_INDICES = 1 << 18;
+
+GeometryPool::GeometryPool()
+	: mVAO(0), mVBO(0), mEBO(0), mIndirect(0), mVertices(INITIAL_VERTICES),
+	  mIndices(INITIAL_INDICES), mInstanceBuffer(0), mIndirectCapacity(0), mMultiDraw(nullptr) {
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	// The commands carry a base instance, which has to be 0 without GL 4.2 or the extension
+	const bool baseInstance = major > 4 || (major == 4 && minor >= 2) ||
+							  GLManager::extensionSupported("GL_ARB_base_instance");
+	const bool multiDraw = major > 4 || (major == 4 && minor >= 3) ||
+						   GLManager::extensionSupported("GL_ARB_multi_draw_indirect");
+
+	if (multiDraw && baseInstance) {
+		mMultiDraw = reinterpret_cast<MultiDrawProc>(
+			GLManager::getProcAddress("glMultiDrawElementsIndirect"));
+	}
+
+	SDL_Log("Geometry pool: %s", mMultiDraw != nullptr ? "multi draw indirect" : "base vertex draws");
+
+	glGenBuffers(1, &mVBO);
+	glGenBuffers(1, &mEBO);
+	glGenBuffers(1, &mIndirect);
+	glGenVertexArrays(1, &mVAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+
+	GLState::bindVertexArray(mVAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), nullptr,
+				 GL_STATIC_DRAW);
+
+	setupAttributes();
+
+	mInstance = this;
+}
+
+GeometryPool::~GeometryPool() {
+	mInstance = nullptr;
+
+	GLState::deleteVertexArray(mVAO);
+	glDeleteBuffers(1, &mVBO);
+	glDeleteBuffers(1, &mEBO);
+	glDeleteBuffers(1, &mIndirect);
+}
+
+// The VAO stores the buffers the attributes point to, so this is redone when they are reallocated
+void GeometryPool::setupAttributes() const {
+	GLState::bindVertexArray(mVAO);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+						  reinterpret_cast<GLvoid*>(offsetof(Vertex, position)));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+						  reinterpret_cast<GLvoid*>(offsetof(Vertex, normal)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+						  reinterpret_cast<GLvoid*>(offsetof(Vertex, texturePos)));
+	glEnableVertexAttribArray(2);
+
+	// Pointed to the instances when drawing, the vertices are only there so they have a buffer
+	for (unsigned int i = 0; i < 4; i++) {
+		glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+		glEnableVertexAttribArray(3 + i);
+		glVertexAttribDivisor(3 + i, 1);
+	}
+}
+
+// Without base instance (before GL 4.2) the instance attributes are moved for every draw instead
+void GeometryPool::setInstanceOffset(GLintptr offset) const {
+	glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+
+	for (unsigned int i = 0; i < 4; i++) {
+		glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Eigen::Matrix4f),
+							  reinterpret_cast<GLvoid*>(offset + i * sizeof(Eigen::Vector4f)));
+	}
+}
+
+void GeometryPool::resize(GLuint& buffer, GLsizeiptr oldSize, GLsizeiptr newSize) {
+	GLuint resized = 0;
+	glGenBuffers(1, &resized);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+	glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+	// Draws of the frames in flight still read from the old one
+	FrameSync::defer([buffer] { glDeleteBuffers(1, &buffer); });
+	buffer = resized;
+}
+
+GeometryPool::Allocation GeometryPool::allocate(const std::vector<Vertex>& vertices,
+												const std::vector<unsigned int>& indices) {
+	GLuint baseVertex = 0;
+	GLuint firstIndex = 0;
+
+	while (!mVertices.allocate(vertices.size(), baseVertex)) {
+		const GLuint size = mVertices.size();
+		mVertices.grow(size * 2);
+
+		resize(mVBO, size * sizeof(Vertex), size * 2 * sizeof(Vertex));
+	}
+
+	while (!mIndices.allocate(indices.size(), firstIndex)) {
+		const GLuint size = mIndices.size();
+		mIndices.grow(size * 2);
+
+		resize(mEBO, size * sizeof(GLuint), size * 2 * sizeof(GLuint));
+	}
+
+	// Points the VAO to the new buffers if they were reallocated
+	setupAttributes();
+
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glBufferSubData(GL_ARRAY_BUFFER, baseVertex * sizeof(Vertex), vertices.size() * sizeof(Vertex),
+					vertices.data());
+
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(GLuint),
+					indices.size() * sizeof(GLuint), indices.data());
+
+	return {static_cast<GLint>(baseVertex), firstIndex, static_cast<GLsizei>(indices.size()),
+			static_cast<GLsizei>(vertices.size())};
+}
+
+void GeometryPool::free(const Allocation& allocation) {
+	mVertices.free(allocation.baseVertex, allocation.vertices);
+	mIndices.free(allocation.firstIndex, allocation.count);
+}
+
+void GeometryPool::bind() const { GLState::bindVertexArray(mVAO); }
+
+void GeometryPool::add(const Allocation& allocation, GLuint buffer, GLintptr offset,
+					   GLsizei count) {
+	mInstanceBuffer = buffer;
+
+	const GLintptr first = mOffsets.empty() ? offset : mOffsets.front();
+	mCommands.emplace_back(Command{static_cast<GLuint>(allocation.count), static_cast<GLuint>(count),
+								   allocation.firstIndex, allocation.baseVertex,
+								   static_cast<GLuint>((offset - first) / sizeof(Eigen::Matrix4f))});
+	mOffsets.emplace_back(offset);
+}
+
+void GeometryPool::flush() {
+	if (mCommands.empty()) {
+		return;
+	}
+
+	bind();
+
+	if (mMultiDraw != nullptr) {
+		setInstanceOffset(mOffsets.front());
+
+		const GLsizeiptr indirectSize = mCommands.size() * sizeof(Command);
+		mIndirectCapacity = std::max(mIndirectCapacity, indirectSize);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirect);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, mIndirectCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, indirectSize, mCommands.data());
+
+		mMultiDraw(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, mCommands.size(), 0);
+	} else {
+		for (size_t i = 0; i < mCommands.size(); i++) {
+			const Command& command = mCommands[i];
+
+			setInstanceOffset(mOffsets[i]);
+			glDrawElementsInstancedBaseVertex(
+				GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+				reinterpret_cast<GLvoid*>(command.firstIndex * sizeof(GLuint)),
+				command.instanceCount, command.baseVertex);
+		}
+	}
+
+	mCommands.clear();
+	mOffsets.clear();
+}
+
+bool GeometryPool::Allocator::allocate(GLuint size, GLuint& offset) {
+	// Nothing to take, the remainder would have the key of the range itself
+	if (size == 0) {
+		offset = 0;
+
+		return true;
+	}
+
+	const auto range = std::find_if(mFree.begin(), mFree.end(),
+									[size](const auto& free) { return free.second >= size; });
+	if (range == mFree.end()) {
+		return false;
+	}
+
+	offset = range->first;
+	const GLuint remainder = range->second - size;
+
+	mFree.erase(range);
+	if (remainder > 0) {
+		mFree.emplace(offset + size, remainder);
+	}
+
+	return true;
+}
+
+void GeometryPool::Allocator::free(GLuint offset, GLuint size) {
+	if (size == 0) {
+		return;
+	}
+
+	auto range = mFree.emplace(offset, size).first;
+
+	// Merge with the following range
+	const auto next = std::next(range);
+	if (next != mFree.end() && range->first + range->second == next->first) {
+		range->second += next->second;
+		mFree.erase(next);
+	}
+
+	// And with the previous one
+	if (range != mFree.begin()) {
+		const auto previous = std::prev(range);
+		if (previous->first + previous->second == range->first) {
+			previous->second += range->second;
+			mFree.erase(range);
+		}
+	}
+}
+
+void GeometryPool::Allocator::grow(GLuint size) {
+	free(mSize, size - mSize);
+
+	mSize = size;
+}
@@ -0,0 +1,223 @@
+#include "opengl/glState.hpp"
+
+#include "opengl/frameSync.hpp"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+GLuint GLState::mProgram = GLState::UNKNOWN;
+GLuint GLState::mVertexArray = GLState::UNKNOWN;
+GLuint GLState::mFramebuffer = GLState::UNKNOWN;
+
+unsigned int GLState::mActiveUnit = GLState::UNKNOWN;
+std::array<std::array<GLuint, GLState::TARGETS>, GLState::UNITS> GLState::mTextures;
+
+uint32_t GLState::mEnabled = 0;
+uint32_t GLState::mKnown = 0;
+GLenum GLState::mDepthFunc = GLState::UNKNOWN;
+GLenum GLState::mCullFace = GLState::UNKNOWN;
+GLenum GLState::mBlendSource = GLState::UNKNOWN;
+GLenum GLState::mBlendDestination = GLState::UNKNOWN;
+GLenum GLState::mPolygonMode = GLState::UNKNOWN;
+
+GLState::Stats GLState::mStats = {0, 0};
+GLState::Stats GLState::mLastFrame = {0, 0};
+
+void GLState::reset() {
+	mProgram = UNKNOWN;
+	mVertexArray = UNKNOWN;
+	mFramebuffer = UNKNOWN;
+
+	mActiveUnit = UNKNOWN;
+	for (auto& unit : mTextures) {
+		unit.fill(UNKNOWN);
+	}
+
+	mEnabled = 0;
+	mKnown = 0;
+	mDepthFunc = UNKNOWN;
+	mCullFace = UNKNOWN;
+	mBlendSource = UNKNOWN;
+	mBlendDestination = UNKNOWN;
+	mPolygonMode = UNKNOWN;
+}
+
+GLState::Stats GLState::frame() {
+	mLastFrame = mStats;
+	mStats = {0, 0};
+
+	return mLastFrame;
+}
+
+bool GLState::changed(bool different) {
+	mStats.calls++;
+
+	if (!different) {
+		mStats.elided++;
+	}
+
+	return different;
+}
+
+void GLState::useProgram(GLuint program) {
+	if (changed(mProgram != program)) {
+		mProgram = program;
+		glUseProgram(program);
+	}
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+	if (changed(mVertexArray != vao)) {
+		mVertexArray = vao;
+		glBindVertexArray(vao);
+	}
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+	if (changed(mFramebuffer != framebuffer)) {
+		mFramebuffer = framebuffer;
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+}
+
+static unsigned int targetIndex(GLenum target) {
+	switch (target) {
+		case GL_TEXTURE_2D:
+			return 0;
+		case GL_TEXTURE_CUBE_MAP:
+			return 1;
+		[[unlikely]] default:
+			SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Untracked texture target %u\n", target);
+
+			return 0;
+	}
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, GLuint texture) {
+	assert(unit < UNITS);
+
+	GLuint& bound = mTextures[unit][targetIndex(target)];
+	if (!changed(bound != texture)) {
+		return;
+	}
+
+	if (changed(mActiveUnit != unit)) {
+		mActiveUnit = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	bound = texture;
+	glBindTexture(target, texture);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+	if (mActiveUnit == UNKNOWN) {
+		mActiveUnit = 0;
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	GLuint& bound = mTextures[mActiveUnit][targetIndex(target)];
+	if (changed(bound != texture)) {
+		bound = texture;
+		glBindTexture(target, texture);
+	}
+}
+
+void GLState::setCapability(GLenum capability, bool enabled) {
+	const auto iter = std::find(CAPABILITIES.begin(), CAPABILITIES.end(), capability);
+
+	// Not tracked, always goes through
+	if (iter == CAPABILITIES.end()) {
+		mStats.calls++;
+		enabled ? glEnable(capability) : glDisable(capability);
+
+		return;
+	}
+
+	const uint32_t bit = 1u << (iter - CAPABILITIES.begin());
+	if (!changed(!(mKnown & bit) || static_cast<bool>(mEnabled & bit) != enabled)) {
+		return;
+	}
+
+	mKnown |= bit;
+	if (enabled) {
+		mEnabled |= bit;
+		glEnable(capability);
+	} else {
+		mEnabled &= ~bit;
+		glDisable(capability);
+	}
+}
+
+void GLState::enable(GLenum capability) { setCapability(capability, true); }
+
+void GLState::disable(GLenum capability) { setCapability(capability, false); }
+
+void GLState::depthFunc(GLenum func) {
+	if (changed(mDepthFunc != func)) {
+		mDepthFunc = func;
+		glDepthFunc(func);
+	}
+}
+
+void GLState::cullFace(GLenum face) {
+	if (changed(mCullFace != face)) {
+		mCullFace = face;
+		glCullFace(face);
+	}
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+	if (changed(mBlendSource != source || mBlendDestination != destination)) {
+		mBlendSource = source;
+		mBlendDestination = destination;
+		glBlendFunc(source, destination);
+	}
+}
+
+void GLState::polygonMode(GLenum mode) {
+#ifdef GLES
+	(void)mode;
+#else
+	if (changed(mPolygonMode != mode)) {
+		mPolygonMode = mode;
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+#endif
+}
+
+void GLState::deleteProgram(GLuint program) {
+	if (mProgram == program) {
+		mProgram = UNKNOWN;
+	}
+
+	FrameSync::defer([program] { glDeleteProgram(program); });
+}
+
+void GLState::deleteVertexArray(GLuint vao) {
+	if (mVertexArray == vao) {
+		mVertexArray = UNKNOWN;
+	}
+
+	FrameSync::defer([vao] { glDeleteVertexArrays(1, &vao); });
+}
+
+void GLState::deleteFramebuffer(GLuint framebuffer) {
+	if (mFramebuffer == framebuffer) {
+		mFramebuffer = UNKNOWN;
+	}
+
+	FrameSync::defer([framebuffer] { glDeleteFramebuffers(1, &framebuffer); });
+}
+
+void GLState::deleteTexture(GLuint texture) {
+	for (auto& unit : mTextures) {
+		std::replace(unit.begin(), unit.end(), texture, UNKNOWN);
+	}
+
+	FrameSync::defer([texture] { glDeleteTextures(1, &texture); });
+}
@@ -0,0 +1,207 @@
+#include "opengl/gpuProfiler.hpp"
+
+#include "managers/glManager.hpp"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+GPUProfiler* GPUProfiler::mInstance = nullptr;
+
+#ifdef HEADLESS
+// There is no panel to look at, the averages are logged every so many frames
+static constexpr unsigned int LOG_INTERVAL = 300;
+#endif
+
+GPUProfiler::GPUProfiler()
+	: mFrames{}, mFrame(0), mHistory{}, mHistoryOffset(0), mRead(0), mQueryCounter(nullptr),
+	  mGetQueryObject(nullptr) {
+#ifdef GLES
+	if (GLManager::extensionSupported("GL_EXT_disjoint_timer_query")) {
+		mQueryCounter =
+			reinterpret_cast<PFNGLQUERYCOUNTERPROC>(GLManager::getProcAddress("glQueryCounterEXT"));
+		mGetQueryObject = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(
+			GLManager::getProcAddress("glGetQueryObjectui64vEXT"));
+	}
+#else
+	mQueryCounter = glQueryCounter;
+	mGetQueryObject = glGetQueryObjectui64v;
+#endif
+
+	if (mQueryCounter == nullptr || mGetQueryObject == nullptr) {
+		mQueryCounter = nullptr;
+
+		SDL_Log("No timer queries, the GPU profiler is disabled");
+	}
+
+	mInstance = this;
+}
+
+GPUProfiler::~GPUProfiler() {
+	mInstance = nullptr;
+
+#ifdef HEADLESS
+	log();
+#endif
+
+	for (Frame& frame : mFrames) {
+		if (!frame.queries.empty()) {
+			glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+		}
+	}
+}
+
+GLuint GPUProfiler::query(Frame& frame) {
+	if (frame.used == frame.queries.size()) {
+		GLuint query = 0;
+		glGenQueries(1, &query);
+
+		frame.queries.emplace_back(query);
+	}
+
+	const GLuint query = frame.queries[frame.used++];
+	mQueryCounter(query, GL_TIMESTAMP);
+
+	return query;
+}
+
+void GPUProfiler::begin(const std::string_view& name) {
+	if (!isSupported()) {
+		return;
+	}
+
+	Frame& frame = mFrames[mFrame];
+
+	frame.open.emplace_back(frame.markers.size());
+	frame.markers.push_back({std::string(name), static_cast<unsigned int>(frame.open.size() - 1),
+							 query(frame), 0});
+}
+
+void GPUProfiler::end() {
+	Frame& frame = mFrames[mFrame];
+
+	if (!isSupported() || frame.open.empty()) {
+		return;
+	}
+
+	frame.markers[frame.open.back()].end = query(frame);
+	frame.open.pop_back();
+}
+
+void GPUProfiler::frame() {
+	if (!isSupported()) {
+		return;
+	}
+
+	// Passes left open end with the frame
+	while (!mFrames[mFrame].open.empty()) {
+		end();
+	}
+
+	mFrame = (mFrame + 1) % FRAMES;
+
+	Frame& next = mFrames[mFrame];
+	read(next);
+
+	next.markers.clear();
+	next.used = 0;
+}
+
+void GPUProfiler::read(Frame& frame) {
+	if (frame.markers.empty()) {
+		return;
+	}
+
+	// Queries finish in order, if the last one is done all of them are
+	GLuint available = 0;
+	glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available == 0) {
+		return;
+	}
+
+#ifdef GLES
+	// The results are garbage after a disjoint operation like a power state change
+	GLint disjoint = 0;
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+	if (disjoint != 0) {
+		return;
+	}
+#endif
+
+	std::vector<Pass> passes;
+	float total = 0.0f;
+
+	for (const Marker& marker : frame.markers) {
+		GLuint64 start = 0;
+		GLuint64 end = 0;
+		mGetQueryObject(marker.start, GL_QUERY_RESULT, &start);
+		mGetQueryObject(marker.end, GL_QUERY_RESULT, &end);
+
+		const float time = static_cast<float>(end - start) / 1000000.0f;
+		if (marker.depth == 0) {
+			total += time;
+		}
+
+		const auto pass = std::find_if(passes.begin(), passes.end(), [&marker](const Pass& other) {
+			return other.name == marker.name && other.depth == marker.depth;
+		});
+		if (pass != passes.end()) {
+			pass->time += time;
+		} else {
+			passes.push_back({marker.name, marker.depth, time});
+		}
+	}
+
+	// Smooth against the same pass of the previous frames
+	for (Pass& pass : passes) {
+		const auto sum = std::find_if(mTotals.begin(), mTotals.end(),
+									  [&pass](const Total& other) { return other.name == pass.name; });
+		if (sum != mTotals.end()) {
+			sum->time += pass.time;
+			sum->frames++;
+		} else {
+			mTotals.push_back({pass.name, pass.time, 1});
+		}
+
+		const auto last = std::find_if(mPasses.begin(), mPasses.end(), [&pass](const Pass& other) {
+			return other.name == pass.name && other.depth == pass.depth;
+		});
+		if (last != mPasses.end()) {
+			pass.time = last->time + (pass.time - last->time) * 0.1f;
+		}
+	}
+
+	mPasses = std::move(passes);
+
+	mHistory[mHistoryOffset] = total;
+	mHistoryOffset = (mHistoryOffset + 1) % HISTORY;
+
+	mRead++;
+#ifdef HEADLESS
+	if (mRead == LOG_INTERVAL) {
+		log();
+	}
+#endif
+}
+
+void GPUProfiler::log() {
+	if (mRead == 0) {
+		return;
+	}
+
+	SDL_Log("GPU passes over %u frames:", mRead);
+	for (const Total& total : mTotals) {
+		SDL_Log("  %-24s %8.3f ms (in %u frames)", total.name.data(), total.time / total.frames,
+				total.frames);
+	}
+
+	mTotals.clear();
+	mRead = 0;
+}
@@ -1,23 +1,43 @@
 #include "opengl/mesh.hpp"
 
+#include "opengl/frameSync.hpp"
+#include "opengl/geometryPool.hpp"
+#include "opengl/glState.hpp"
 #include "opengl/shader.hpp"
 #include "opengl/texture.hpp"
 #include "opengl/types.hpp"
 #include "third_party/glad/glad.h"
 
+#include <array>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
 
+static unsigned int meshCount = 0;
+
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
 		   const std::vector<std::pair<Texture*, TextureType>>& textures)
-	: mVBO(0), mEBO(0), mVAO(0), mVertices(vertices), mIndices(indices), mTextures(textures) {
+	: mID(meshCount++), mMaterial(0), mPooled(GeometryPool::get() != nullptr),
+	  mAllocation{0, 0, 0, 0}, mVBO(0), mEBO(0), mVAO(0), mVertices(vertices), mIndices(indices), mTextures(textures) {
+	updateMaterial();
+
+	for (const auto& vertex : mVertices) {
+		mBounds.extend(vertex.position);
+	}
+
+	if (mPooled) {
+		mAllocation = GeometryPool::get()->allocate(mVertices, mIndices);
+
+		return;
+	}
+
 	glGenBuffers(1, &mVBO);
 	glGenBuffers(1, &mEBO);
 
 	// Save the conf to VAO
 	glGenVertexArrays(1, &mVAO);
-	glBindVertexArray(mVAO);
+	GLState::bindVertexArray(mVAO);
 
 	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
 	glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(mVertices[0]), mVertices.data(),
@@ -37,18 +57,63 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>&
 						  reinterpret_cast<GLvoid*>(offsetof(Vertex, texturePos)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	// The model matrix of every instance, a mat4 is 4 vec4 attributes pointed to when drawing
+	// Until then they point to the vertices, so no enabled attribute is left without a buffer
+	for (unsigned int i = 0; i < 4; i++) {
+		glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+		glEnableVertexAttribArray(3 + i);
+		glVertexAttribDivisor(3 + i, 1);
+	}
 }
 
 Mesh::~Mesh() {
-	glDeleteVertexArrays(1, &mVAO);
-	glDeleteBuffers(1, &mVBO);
-	glDeleteBuffers(1, &mEBO);
+	if (mPooled) {
+		GeometryPool::get()->free(mAllocation);
+
+		return;
+	}
+
+	GLState::deleteVertexArray(mVAO);
+
+	const std::array<GLuint, 2> buffers = {mVBO, mEBO};
+	FrameSync::defer([buffers] { glDeleteBuffers(buffers.size(), buffers.data()); });
+}
+
+void Mesh::bind() const {
+	if (mPooled) {
+		GeometryPool::get()->bind();
+	} else {
+		GLState::bindVertexArray(mVAO);
+	}
 }
 
-#include <SDL3/SDL.h>
-#include <iostream>
-void Mesh::draw(const Shader* shader) const {
+void Mesh::draw() const {
+	if (mPooled) {
+		glDrawElementsBaseVertex(GL_TRIANGLES, mAllocation.count, GL_UNSIGNED_INT,
+								 reinterpret_cast<GLvoid*>(mAllocation.firstIndex * sizeof(GLuint)),
+								 mAllocation.baseVertex);
+	} else {
+		glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, nullptr);
+	}
+}
+
+void Mesh::addTexture(std::pair<Texture*, TextureType> texture) {
+	mTextures.emplace_back(texture);
+
+	updateMaterial();
+}
+
+// Hash of the texture set, collisions only make the sorting worse
+void Mesh::updateMaterial() {
+	size_t hash = 0;
+	for (const auto& [texture, type] : mTextures) {
+		hash = hash * 31 + std::hash<Texture*>{}(texture) + type;
+	}
+
+	mMaterial = static_cast<unsigned int>(hash ^ (hash >> 12) ^ (hash >> 24));
+}
+
+void Mesh::bindTextures(const Shader* shader) const {
 	unsigned int diffuse = 0;
 	unsigned int specular = 0;
 	unsigned int height = 0;
@@ -81,11 +146,17 @@ void Mesh::draw(const Shader* shader) const {
 		shader->set(name + number, i);
 
 		mTextures[i].first->activate(i);
-		// TODO: Std function????
-		// https://stackoverflow.com/questions/10022789/stdfunction-with-non-static-member-functions
+	}
+}
+
+void Mesh::drawInstanced(GLuint buffer, GLintptr offset, GLsizei count) const {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	for (unsigned int i = 0; i < 4; i++) {
+		glVertexAttribPointer(
+			3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Eigen::Matrix4f),
+			reinterpret_cast<GLvoid*>(offset + i * sizeof(Eigen::Vector4f)));
 	}
 
-	glBindVertexArray(mVAO);
-	glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
+	glDrawElementsInstanced(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, nullptr, count);
 }
@@ -0,0 +1,221 @@
+#include "opengl/occlusionCuller.hpp"
+
+#include "opengl/mesh.hpp"
+#include "opengl/types.hpp"
+#include "profiler.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+static_assert(OcclusionCuller::WIDTH >> (OcclusionCuller::LEVELS - 1) >= 1);
+static_assert(OcclusionCuller::HEIGHT >> (OcclusionCuller::LEVELS - 1) == 1);
+
+// Rows drawn by a thread, fewer aren't worth the handoff
+static constexpr size_t BAND_GRAIN = 8;
+
+// Clamped before the conversion, vertices far off the screen don't fit into an int
+static int pixel(float coordinate, int size) {
+	return static_cast<int>(std::clamp(coordinate, -1.0f, static_cast<float>(size)));
+}
+
+OcclusionCuller::OcclusionCuller()
+	: mViewProjection(Eigen::Matrix4f::Identity()), mNear(0.1f),
+	  mColumns(Eigen::ArrayXf::LinSpaced(WIDTH, 0.5f, static_cast<float>(WIDTH) - 0.5f)),
+	  mStats{} {
+	for (int level = 0; level < LEVELS; level++) {
+		mLevels[level].setZero((WIDTH >> level) * (HEIGHT >> level));
+	}
+}
+
+void OcclusionCuller::begin(const Eigen::Matrix4f& viewProjection, float near) {
+	mViewProjection = viewProjection;
+	mNear = near;
+
+	mTriangles.clear();
+	mStats = {};
+}
+
+void OcclusionCuller::add(const Mesh& mesh, const Eigen::Affine3f& model) {
+	const Eigen::Matrix4f transform = mViewProjection * model.matrix();
+	const std::vector<Vertex>& vertices = mesh.getVertexData();
+	const std::vector<unsigned int>& indices = mesh.getIndexData();
+
+	mClip.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		mClip[i] = transform * vertices[i].position.homogeneous();
+	}
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const std::array<Eigen::Vector4f, 3> triangle = {mClip[indices[i]], mClip[indices[i + 1]],
+														 mClip[indices[i + 2]]};
+
+		// Clipped against the near plane, which leaves a triangle or a quad. Walls next to the
+		// camera and the floor under it always cross it
+		std::array<Eigen::Vector4f, 4> polygon;
+		size_t count = 0;
+		for (size_t j = 0; j < 3; j++) {
+			const Eigen::Vector4f& from = triangle[j];
+			const Eigen::Vector4f& to = triangle[(j + 1) % 3];
+			const bool fromInside = from.w() >= mNear;
+			const bool toInside = to.w() >= mNear;
+
+			if (fromInside) {
+				polygon[count++] = from;
+			}
+			if (fromInside != toInside) {
+				polygon[count++] = from + (to - from) * ((mNear - from.w()) / (to.w() - from.w()));
+			}
+		}
+
+		for (size_t j = 2; j < count; j++) {
+			setup(project(polygon[0]), project(polygon[j - 1]), project(polygon[j]));
+		}
+	}
+
+	mStats.occluders++;
+	mStats.triangles = static_cast<unsigned int>(mTriangles.size());
+}
+
+Eigen::Vector3f OcclusionCuller::project(const Eigen::Vector4f& clip) {
+	return Eigen::Vector3f((clip.x() / clip.w() * 0.5f + 0.5f) * WIDTH,
+						   (clip.y() / clip.w() * 0.5f + 0.5f) * HEIGHT, 1.0f / clip.w());
+}
+
+void OcclusionCuller::setup(const Eigen::Vector3f& v0, const Eigen::Vector3f& v1,
+							const Eigen::Vector3f& v2) {
+	// Twice the area, counter clockwise is front facing like in GL
+	const float area =
+		(v1.x() - v0.x()) * (v2.y() - v0.y()) - (v1.y() - v0.y()) * (v2.x() - v0.x());
+	if (!(area > 0.0f)) {
+		return;
+	}
+
+	// The pixels whose centers are inside of the bounds
+	const Eigen::Vector3f min = v0.cwiseMin(v1).cwiseMin(v2);
+	const Eigen::Vector3f max = v0.cwiseMax(v1).cwiseMax(v2);
+
+	Triangle triangle;
+	triangle.minX = std::max(pixel(std::ceil(min.x() - 0.5f), WIDTH), 0);
+	triangle.maxX = std::min(pixel(std::floor(max.x() - 0.5f), WIDTH), WIDTH - 1);
+	triangle.minY = std::max(pixel(std::ceil(min.y() - 0.5f), HEIGHT), 0);
+	triangle.maxY = std::min(pixel(std::floor(max.y() - 0.5f), HEIGHT), HEIGHT - 1);
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+		return;
+	}
+
+	// The edge across from every vertex, which is its barycentric weight times the area
+	const auto edge = [](const Eigen::Vector3f& from, const Eigen::Vector3f& to) {
+		return Eigen::Vector3f(from.y() - to.y(), to.x() - from.x(),
+							   from.x() * to.y() - from.y() * to.x());
+	};
+	triangle.edges = {edge(v1, v2), edge(v2, v0), edge(v0, v1)};
+	triangle.depth = (triangle.edges[0] * v0.z() + triangle.edges[1] * v1.z() +
+					  triangle.edges[2] * v2.z()) /
+					 area;
+
+	mTriangles.emplace_back(triangle);
+}
+
+void OcclusionCuller::rasterize(ThreadPool& workers) {
+	PROFILE_SCOPE("OcclusionCuller::rasterize");
+
+	mLevels[0].setZero();
+
+	// Every band only writes its own rows
+	const auto band = [this](size_t, size_t begin, size_t end) {
+		for (const Triangle& triangle : mTriangles) {
+			draw(triangle, static_cast<int>(begin), static_cast<int>(end));
+		}
+	};
+	workers.run(HEIGHT, workers.chunks(HEIGHT, BAND_GRAIN), band);
+
+	for (int level = 1; level < LEVELS; level++) {
+		const int width = WIDTH >> level;
+		const int height = HEIGHT >> level;
+		const Eigen::ArrayXf& below = mLevels[level - 1];
+
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				const int corner = (y * 2) * (width * 2) + x * 2;
+
+				mLevels[level][y * width + x] =
+					std::min(std::min(below[corner], below[corner + 1]),
+							 std::min(below[corner + width * 2], below[corner + width * 2 + 1]));
+			}
+		}
+	}
+}
+
+void OcclusionCuller::draw(const Triangle& triangle, int begin, int end) {
+	const int n = triangle.maxX - triangle.minX + 1;
+	const auto x = mColumns.segment(triangle.minX, n);
+	const auto& [e0, e1, e2] = triangle.edges;
+
+	for (int y = std::max(triangle.minY, begin); y <= std::min(triangle.maxY, end - 1); y++) {
+		const float center = static_cast<float>(y) + 0.5f;
+		Eigen::Map<Eigen::ArrayXf> row(mLevels[0].data() + y * WIDTH + triangle.minX, n);
+
+		// Keeps the closest, a whole span of the row at a time
+		row = (x * e0.x() + (center * e0.y() + e0.z()) >= 0.0f &&
+			   x * e1.x() + (center * e1.y() + e1.z()) >= 0.0f &&
+			   x * e2.x() + (center * e2.y() + e2.z()) >= 0.0f)
+				  .select(row.max(x * triangle.depth.x() +
+								  (center * triangle.depth.y() + triangle.depth.z())),
+						  row);
+	}
+}
+
+bool OcclusionCuller::occluded(const Eigen::Vector3f& center, const Eigen::Vector3f& extent) const {
+	// Nothing drawn, or a box that isn't cullable
+	if (mTriangles.empty() || extent.maxCoeff() >= std::numeric_limits<float>::max()) {
+		return false;
+	}
+
+	Eigen::Matrix<float, 4, 8> corners;
+	for (int i = 0; i < 8; i++) {
+		const Eigen::Vector3f sign((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f,
+								   (i & 4) ? 1.0f : -1.0f);
+		corners.col(i) = (center + extent.cwiseProduct(sign)).homogeneous();
+	}
+	const Eigen::Matrix<float, 4, 8> clip = mViewProjection * corners;
+
+	// Reaching past the near plane it could cover the whole screen
+	if (!(clip.row(3).minCoeff() >= mNear)) {
+		return false;
+	}
+
+	const Eigen::Array<float, 1, 8> depth = clip.row(3).array().inverse();
+	const Eigen::Array<float, 1, 8> x = (clip.row(0).array() * depth * 0.5f + 0.5f) * WIDTH;
+	const Eigen::Array<float, 1, 8> y = (clip.row(1).array() * depth * 0.5f + 0.5f) * HEIGHT;
+
+	// Every pixel the box touches, not only the ones whose centers it covers
+	const int minX = std::max(pixel(std::floor(x.minCoeff()), WIDTH), 0);
+	const int maxX = std::min(pixel(std::floor(x.maxCoeff()), WIDTH), WIDTH - 1);
+	const int minY = std::max(pixel(std::floor(y.minCoeff()), HEIGHT), 0);
+	const int maxY = std::min(pixel(std::floor(y.maxCoeff()), HEIGHT), HEIGHT - 1);
+	if (minX > maxX || minY > maxY) {
+		return false;
+	}
+
+	// The finest level the box is at most 2x2 texels on
+	int level = 0;
+	while (level < LEVELS - 1 &&
+		   ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1)) {
+		level++;
+	}
+
+	const int width = WIDTH >> level;
+	float farthest = std::numeric_limits<float>::max();
+	for (int texelY = minY >> level; texelY <= maxY >> level; texelY++) {
+		for (int texelX = minX >> level; texelX <= maxX >> level; texelX++) {
+			farthest = std::min(farthest, mLevels[level][texelY * width + texelX]);
+		}
+	}
+
+	return depth.maxCoeff() < farthest;
+}
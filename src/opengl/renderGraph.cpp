@@ -0,0 +1,274 @@
+#include "opengl/renderGraph.hpp"
+
+#include "game.hpp"
+#include "opengl/glState.hpp"
+#include "opengl/gpuProfiler.hpp"
+#include "opengl/mesh.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/types.hpp"
+#include "profiler.hpp"
+#include "third_party/Eigen/Dense"
+#include "third_party/glad/glad.h"
+#include "utils.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+static constexpr size_t NONE = SIZE_MAX;
+// Frames an unused target is kept for, effects that are turned back on don't allocate again
+static constexpr unsigned int IDLE_FRAMES = 120;
+
+RenderGraph::RenderGraph(Game* owner, const Mesh* quad)
+	: mOwner(owner), mQuad(quad), mWidth(0), mHeight(0), mScale(1.0f), mSceneFramebuffer(0),
+	  mSceneTexture(0), mHeld(NONE), mStats{} {}
+
+RenderGraph::~RenderGraph() {
+	for (const Target& target : mTargets) {
+		destroy(target);
+	}
+}
+
+void RenderGraph::begin(GLuint framebuffer, GLuint texture, int width, int height, float scale) {
+	mSceneFramebuffer = framebuffer;
+	mSceneTexture = texture;
+	mScale = scale;
+
+	mPasses.clear();
+	mAssigned.assign(1, NONE);
+
+	if (mHeld != NONE) {
+		mTargets[mHeld].used = false;
+		mHeld = NONE;
+	}
+
+	// Nothing is assigned between frames, so the targets can move
+	const bool resized = width != mWidth || height != mHeight;
+	mWidth = width;
+	mHeight = height;
+
+	for (size_t i = 0; i < mTargets.size();) {
+		Target& target = mTargets[i];
+
+		if (resized || ++target.idle > IDLE_FRAMES) {
+			destroy(target);
+
+			std::swap(target, mTargets.back());
+			mTargets.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+RenderGraph::Resource RenderGraph::create() {
+	mAssigned.emplace_back(NONE);
+
+	return static_cast<Resource>(mAssigned.size() - 1);
+}
+
+void RenderGraph::addPass(Pass pass) {
+	// Every resource is written once, by the pass declared first, and read after
+	assert(pass.output != SCENE && pass.output < mAssigned.size());
+	assert(pass.merge.empty() || pass.shader == "framebuffer.frag");
+
+	mPasses.emplace_back(std::move(pass));
+}
+
+RenderGraph::Blit RenderGraph::execute(Resource output) {
+	PROFILE_SCOPE("RenderGraph::execute");
+
+	const size_t count = mPasses.size();
+
+	// Walking back from the output, a pass is needed when something needed reads what it writes
+	std::vector<bool> needed(count, false);
+	std::vector<bool> wanted(mAssigned.size(), false);
+	std::vector<size_t> producer(mAssigned.size(), NONE);
+	wanted[output] = true;
+
+	for (size_t i = count; i-- > 0;) {
+		const Pass& pass = mPasses[i];
+		if (!wanted[pass.output]) {
+			continue;
+		}
+
+		needed[i] = true;
+		producer[pass.output] = i;
+		for (const Resource input : pass.inputs) {
+			wanted[input] = true;
+		}
+	}
+
+	mStats = {static_cast<unsigned int>(count),
+			  static_cast<unsigned int>(std::count(needed.begin(), needed.end(), false)), 0, 0};
+
+	std::vector<unsigned int> readers(mAssigned.size(), 0);
+	for (size_t i = 0; i < count; i++) {
+		for (const Resource input : mPasses[i].inputs) {
+			readers[input] += needed[i] ? 1 : 0;
+		}
+	}
+
+	// Per pixel passes at the end are folded into the final blit, as long as only the next of them
+	// reads what they write
+	Blit blit = {};
+	std::vector<size_t> merged;
+	Resource source = output;
+
+	while (producer[source] != NONE) {
+		const Pass& pass = mPasses[producer[source]];
+
+		if (pass.merge.empty() || pass.inputs.size() != 1 || readers[source] != 0 ||
+			blit.defines.contains(pass.merge)) {
+			break;
+		}
+
+		blit.defines[pass.merge] = "1";
+		merged.emplace_back(producer[source]);
+		needed[producer[source]] = false;
+
+		source = pass.inputs.front();
+		readers[source]--;
+	}
+
+	mStats.merged = static_cast<unsigned int>(merged.size());
+
+	// The last pass reading a resource gives its target back
+	std::vector<size_t> lastUse(mAssigned.size(), NONE);
+	for (size_t i = 0; i < count; i++) {
+		if (needed[i]) {
+			for (const Resource input : mPasses[i].inputs) {
+				lastUse[input] = i;
+			}
+		}
+	}
+
+	const int width = std::max(static_cast<int>(std::lround(mWidth * mScale)), 1);
+	const int height = std::max(static_cast<int>(std::lround(mHeight * mScale)), 1);
+
+	if (std::find(needed.begin(), needed.end(), true) != needed.end()) {
+		GLState::disable(GL_DEPTH_TEST);
+		glViewport(0, 0, width, height);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!needed[i]) {
+			continue;
+		}
+
+		const Pass& pass = mPasses[i];
+		const GPUProfiler::Scope scope(pass.name);
+
+		// Before the inputs are given back, so that a pass never writes what it reads
+		const size_t target = acquire();
+		mAssigned[pass.output] = target;
+		GLState::bindFramebuffer(mTargets[target].framebuffer);
+
+		ShaderDefines defines;
+		if (!pass.merge.empty()) {
+			defines[pass.merge] = "1";
+		}
+
+		const Shader* shader = mOwner->getShader("framebuffer.vert", pass.shader, defines);
+		shader->activate();
+		shader->set("scale", mScale);
+
+		// Drawn where it is instead of in the final blit
+		if (!pass.merge.empty()) {
+			shader->set("reprojection", Eigen::Matrix3f::Identity().eval());
+		}
+
+		for (size_t j = 0; j < pass.inputs.size(); j++) {
+			GLState::bindTexture(static_cast<unsigned int>(j), GL_TEXTURE_2D,
+								 getTexture(pass.inputs[j]));
+			shader->set(j == 0 ? std::string("screen") : "screen" + std::to_string(j),
+						static_cast<GLint>(j));
+		}
+
+		if (pass.uniforms) {
+			pass.uniforms(shader);
+		}
+
+		mQuad->bind();
+		mQuad->draw();
+
+		for (const Resource input : pass.inputs) {
+			if (input != SCENE && input != source && lastUse[input] == i) {
+				mTargets[mAssigned[input]].used = false;
+			}
+		}
+	}
+
+	// The merged passes are collected from the back
+	for (auto iter = merged.rbegin(); iter != merged.rend(); iter++) {
+		blit.uniforms.emplace_back(mPasses[*iter].uniforms);
+	}
+
+	if (source == SCENE) {
+		blit.framebuffer = mSceneFramebuffer;
+		blit.texture = mSceneTexture;
+	} else {
+		mHeld = mAssigned[source];
+		blit.framebuffer = mTargets[mHeld].framebuffer;
+		blit.texture = mTargets[mHeld].texture;
+	}
+
+	mStats.targets = static_cast<unsigned int>(mTargets.size());
+
+	return blit;
+}
+
+size_t RenderGraph::acquire() {
+	for (size_t i = 0; i < mTargets.size(); i++) {
+		if (!mTargets[i].used) {
+			mTargets[i].used = true;
+			mTargets[i].idle = 0;
+
+			return i;
+		}
+	}
+
+	Target target = {0, 0, mWidth, mHeight, true, 0};
+
+	glGenTextures(1, &target.texture);
+	GLState::bindTexture(GL_TEXTURE_2D, target.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+				 nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &target.framebuffer);
+	GLState::bindFramebuffer(target.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture,
+						   0);
+
+	[[unlikely]] if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Post processing target is not complete\n");
+		ERROR_BOX("Failed to create a post processing target, you might not have enough memory");
+
+		throw std::runtime_error("renderGraph.cpp: Failed to create a target");
+	}
+
+	SDL_Log("Post processing target %zu: %dx%d", mTargets.size(), mWidth, mHeight);
+
+	mTargets.emplace_back(target);
+
+	return mTargets.size() - 1;
+}
+
+void RenderGraph::destroy(const Target& target) const {
+	GLState::deleteFramebuffer(target.framebuffer);
+	GLState::deleteTexture(target.texture);
+}
+
+GLuint RenderGraph::getTexture(Resource resource) const {
+	return resource == SCENE ? mSceneTexture : mTargets[mAssigned[resource]].texture;
+}
@@ -0,0 +1,185 @@
+#include "opengl/renderQueue.hpp"
+
+#include "opengl/mesh.hpp"
+#include "opengl/occlusionCuller.hpp"
+#include "opengl/shader.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+RenderQueue::Lane::Lane()
+	: mCulled(0), mOccluded(0), mEye(Eigen::Vector3f::Zero()), mFar(100.0f) {}
+
+void RenderQueue::Lane::clear(const Eigen::Vector3f& eye, float far) {
+	mPackets.clear();
+	for (auto& bounds : mBounds) {
+		bounds.clear();
+	}
+
+	mEye = eye;
+	mFar = far;
+}
+
+RenderQueue::RenderQueue(ThreadPool& workers)
+	: mWorkers(workers), mLanes(1), mCulled(0), mOccluded(0) {}
+
+void RenderQueue::clear(const Eigen::Vector3f& eye, float far, size_t lanes) {
+	// Lanes are kept, so their packets don't have to grow again every frame
+	mLanes.resize(std::max(lanes, size_t{1}));
+
+	for (Lane& lane : mLanes) {
+		lane.clear(eye, far);
+	}
+
+	mPackets.clear();
+	mCulled = 0;
+	mOccluded = 0;
+}
+
+uint64_t RenderQueue::key(int layer, unsigned int program, unsigned int material,
+						  unsigned int mesh, float depth) {
+	const uint64_t quantized =
+		static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(0xFFF));
+
+	return (static_cast<uint64_t>(std::clamp(layer, 0, 0xFFFF)) << 48) |
+		   (static_cast<uint64_t>(program & 0xFFF) << 36) |
+		   (static_cast<uint64_t>(material & 0xFFF) << 24) |
+		   (static_cast<uint64_t>(mesh & 0xFFF) << 12) | quantized;
+}
+
+void RenderQueue::Lane::push(int layer, Shader* shader, const Mesh* mesh,
+							 const Eigen::Affine3f& model, bool cullable) {
+	// Transform the box as center and half extent, the extent through the absolute matrix
+	const Eigen::Vector3f center = model * mesh->getBounds().center();
+	const Eigen::Vector3f extent = cullable ? Eigen::Vector3f(model.linear().cwiseAbs() *
+															  (mesh->getBounds().sizes() / 2))
+											: Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+
+	for (unsigned int i = 0; i < 3; i++) {
+		mBounds[i].emplace_back(center[i]);
+		mBounds[i + 3].emplace_back(extent[i]);
+	}
+
+	// Front to back inside of a mesh, so that the early depth test can discard more
+	const float depth = (center - mEye).norm() / mFar;
+
+	mPackets.emplace_back(DrawPacket{
+		key(layer, shader->getID(), mesh->getMaterial(), mesh->getID(), depth), shader, mesh, model});
+}
+
+// A box is outside if it is fully behind any of the planes, with the planes extracted from the
+// rows of the view projection (Gribb & Hartmann)
+void RenderQueue::Lane::cull(const Eigen::Matrix4f& viewProjection,
+							 const OcclusionCuller* occlusion) {
+	const Eigen::Index size = mPackets.size();
+
+	const Eigen::Map<const Eigen::ArrayXf> x(mBounds[0].data(), size);
+	const Eigen::Map<const Eigen::ArrayXf> y(mBounds[1].data(), size);
+	const Eigen::Map<const Eigen::ArrayXf> z(mBounds[2].data(), size);
+	const Eigen::Map<const Eigen::ArrayXf> ex(mBounds[3].data(), size);
+	const Eigen::Map<const Eigen::ArrayXf> ey(mBounds[4].data(), size);
+	const Eigen::Map<const Eigen::ArrayXf> ez(mBounds[5].data(), size);
+
+	mMargin.setConstant(size, std::numeric_limits<float>::max());
+
+	for (unsigned int i = 0; i < 6; i++) {
+		// left, right, bottom, top, near, far
+		const Eigen::Vector4f plane = viewProjection.row(3) + (i % 2 == 0 ? 1.0f : -1.0f) *
+																	viewProjection.row(i / 2);
+
+		// Signed distance of the center plus the projected radius of the box
+		mMargin = mMargin.min(x * plane.x() + y * plane.y() + z * plane.z() + plane.w() +
+							  ex * std::abs(plane.x()) + ey * std::abs(plane.y()) +
+							  ez * std::abs(plane.z()));
+	}
+
+	Eigen::Index visible = 0;
+	mOccluded = 0;
+	for (Eigen::Index i = 0; i < size; i++) {
+		if (mMargin[i] < 0.0f) {
+			continue;
+		}
+
+		// Only what is in the frustum is worth the projection
+		if (occlusion != nullptr &&
+			occlusion->occluded(Eigen::Vector3f(x[i], y[i], z[i]),
+								Eigen::Vector3f(ex[i], ey[i], ez[i]))) {
+			mOccluded++;
+
+			continue;
+		}
+
+		mPackets[visible++] = mPackets[i];
+	}
+
+	mCulled = size - visible - mOccluded;
+	mPackets.resize(visible);
+}
+
+void RenderQueue::cull(const Eigen::Matrix4f& viewProjection, const OcclusionCuller* occlusion) {
+	mWorkers.run(mLanes.size(), mLanes.size(), [&](size_t lane, size_t, size_t) {
+		mLanes[lane].cull(viewProjection, occlusion);
+	});
+
+	mCulled = 0;
+	mOccluded = 0;
+	for (const Lane& lane : mLanes) {
+		mCulled += lane.mCulled;
+		mOccluded += lane.mOccluded;
+	}
+}
+
+// LSD radix sort over the bytes of the key, stable so equal keys keep the recording order
+void RenderQueue::sort() {
+	mPackets.clear();
+	for (const Lane& lane : mLanes) {
+		mPackets.insert(mPackets.end(), lane.mPackets.begin(), lane.mPackets.end());
+	}
+
+	const uint32_t size = mPackets.size();
+
+	mKeys.resize(size);
+	mScratch.resize(size);
+
+	for (uint32_t i = 0; i < size; i++) {
+		mKeys[i] = {mPackets[i].key, i};
+	}
+
+	for (unsigned int shift = 0; shift < 64; shift += 8) {
+		std::array<uint32_t, 256> count = {};
+
+		for (const auto& [key, _] : mKeys) {
+			count[(key >> shift) & 0xFF]++;
+		}
+
+		// Every key has the same byte, nothing to move
+		if (size == 0 || count[(mKeys[0].first >> shift) & 0xFF] == size) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (auto& bucket : count) {
+			offset += std::exchange(bucket, offset);
+		}
+
+		for (const auto& entry : mKeys) {
+			mScratch[count[(entry.first >> shift) & 0xFF]++] = entry;
+		}
+
+		mKeys.swap(mScratch);
+	}
+
+	mSorted.clear();
+	mSorted.reserve(size);
+	for (const auto& [_, index] : mKeys) {
+		mSorted.emplace_back(mPackets[index]);
+	}
+
+	mPackets.swap(mSorted);
+}
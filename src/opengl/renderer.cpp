@@ -3,14 +3,35 @@
 #include "actors/actor.hpp"
 #include "components/cameraComponent.hpp"
 #include "components/drawComponent.hpp"
+#include "components/modelComponent.hpp"
 #include "game.hpp"
 #include "managers/glManager.hpp"
+#include "managers/lightManager.hpp"
+#include "opengl/frameSync.hpp"
 #include "opengl/framebuffer.hpp"
+#include "opengl/geometryPool.hpp"
+#include "opengl/glState.hpp"
+#include "opengl/gpuProfiler.hpp"
+#include "opengl/mesh.hpp"
+#include "opengl/occlusionCuller.hpp"
+#include "opengl/renderQueue.hpp"
+#include "opengl/ringBuffer.hpp"
 #include "opengl/shader.hpp"
+#include "options.hpp"
+#include "profiler.hpp"
+#include "third_party/Eigen/Core"
 #include "third_party/glad/glad.h"
+#include "threadPool.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 #ifdef IMGUI
 #include <backends/imgui_impl_opengl3.h>
@@ -29,12 +50,69 @@ EM_JS(int, canvasResize, (), {
 });
 #endif
 
+// Mirrors the Frame block in assets/shaders/frame.glsl, std140 pads every vec3 to a vec4
+// unless a scalar follows it
+struct FrameData {
+	Eigen::Matrix4f view;
+	Eigen::Matrix4f proj;
+	Eigen::Vector3f viewPos;
+	float padding0;
+
+	struct {
+		Eigen::Vector3f direction;
+		float padding0;
+		Eigen::Vector3f ambient;
+		float padding1;
+		Eigen::Vector3f diffuse;
+		float padding2;
+		Eigen::Vector3f specular;
+		float padding3;
+	} dirLight;
+
+	Eigen::Vector2f lightSlicing;
+	float padding1[2];
+};
+static_assert(offsetof(FrameData, viewPos) == 128);
+static_assert(offsetof(FrameData, dirLight) == 144);
+static_assert(offsetof(FrameData, lightSlicing) == 208);
+static_assert(sizeof(FrameData) == 224);
+
+// Per frame region of the ring buffer, enough for the frame data, the lights and ~16000 instances
+static constexpr GLsizeiptr RING_SIZE = 1 << 20;
+// Tangent of the field of view the scene is drawn with while reprojecting, relative to the camera's
+// Turning shows what was drawn in the margin instead of the stretched edge
+static constexpr float GUARD_BAND = 1.1f;
+// Fewest drawables recorded and models written by a thread, less isn't worth the handoff
+static constexpr size_t RECORD_GRAIN = 16;
+static constexpr size_t MODEL_GRAIN = 256;
+
 Renderer::Renderer(Game* game)
-	: mOwner(game), mWindow(nullptr), mGL(nullptr), mFramebuffer(nullptr), mWidth(0), mHeight(0),
+	: mOwner(game), mThread(std::this_thread::get_id()), mWindow(nullptr), mGL(nullptr),
+	  mProfiler(nullptr), mPool(nullptr), mFramebuffer(nullptr),
+	  mWorkers(std::make_unique<ThreadPool>(game->getOptions().threads)),
+	  mQueue(std::make_unique<RenderQueue>(*mWorkers)),
+	  mOcclusion(std::make_unique<OcclusionCuller>()), mOcclude(true), mRing(nullptr),
+	  mUniformAlignment(256),
+	  mLights(nullptr), mWidth(0),
+	  mHeight(0), mRefreshRate(60), mLowLatency(false),
+	  mReproject(false), mInterval(0), mSinceScene(MAX_INTERVAL),
+	  mSceneRotation(Eigen::Matrix3f::Identity()), mSceneScale(1.0f, 1.0f),
+	  mView(Eigen::Affine3f::Identity()), mProjection(Eigen::Matrix4f::Identity()),
+	  mSceneProjection(Eigen::Matrix4f::Identity()), mEye(Eigen::Vector3f::Zero()),
 	  mCamera(nullptr) {
 	mGL = std::make_unique<GLManager>();
 
-	mWindow = SDL_CreateWindow("Panorama", 1024, 768, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+	const Options& options = mOwner->getOptions();
+
+#ifdef HEADLESS
+	// No window, the frames only end up in the framebuffer
+	mWidth = options.width;
+	mHeight = options.height;
+
+	mGL->bindContext();
+#else
+	mWindow = SDL_CreateWindow("Panorama", options.width, options.height,
+							   SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
 	if (mWindow == nullptr) {
 		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to create window: %s\n", SDL_GetError());
 		ERROR_BOX("Failed to make SDL window, there is something wrong with "
@@ -70,6 +148,7 @@ Renderer::Renderer(Game* game)
 	SDL_SetWindowSize(mWindow, mWidth, mHeight);
 #else
 	SDL_GetWindowSize(mWindow, &mWidth, &mHeight);
+#endif
 #endif
 
 	glViewport(0, 0, mWidth, mHeight);
@@ -81,40 +160,348 @@ Renderer::Renderer(Game* game)
 
 	mGL->printInfo();
 
+	mProfiler = std::make_unique<GPUProfiler>();
+
+#ifndef GLES
+	// GLES 3.0 has neither base vertex nor indirect draws, the meshes keep their own buffers there
+	mPool = std::make_unique<GeometryPool>();
+#endif
+
+	mRing = std::make_unique<RingBuffer>(RING_SIZE);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &mUniformAlignment);
+	mLights = std::make_unique<LightManager>();
+
 	mFramebuffer = std::make_unique<Framebuffer>(mOwner);
+	mFramebuffer->setDemensions(mWidth, mHeight);
+
+#ifndef HEADLESS
+	// Scale the scene to fit in a refresh, the rest of the display modes are assumed to be 60hz
+	const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(mWindow));
+	if (mode != nullptr && mode->refresh_rate > 0.0f) {
+		mFramebuffer->setBudget(1000.0f / mode->refresh_rate);
+		mRefreshRate = static_cast<unsigned int>(std::lround(mode->refresh_rate));
+	}
+#endif
+
+	if (!options.output.empty()) {
+		startCapture(options.output);
+	}
 }
 
-Renderer::~Renderer() { SDL_DestroyWindow(mWindow); }
+Renderer::~Renderer() {
+	// The last frames are read back while the window and its context still exist
+	if (mFramebuffer) {
+		mFramebuffer->stopCapture();
+	}
+
+	// Whatever the frames in flight still use is deleted with the context
+	FrameSync::finish();
+
+	if (mWindow != nullptr) {
+		SDL_DestroyWindow(mWindow);
+	}
+}
+
+void Renderer::setLowLatency(bool lowLatency) {
+	mLowLatency = lowLatency;
+
+	FrameSync::setFramesInFlight(lowLatency ? 1 : FrameSync::FRAMES);
+}
+
+void Renderer::setReprojection(bool reproject, unsigned int interval) {
+	mReproject = reproject;
+	mInterval = std::min(interval, MAX_INTERVAL);
+	mSinceScene = MAX_INTERVAL;
+}
 
 void Renderer::setDemensions(int width, int height) {
 	mWidth = width;
 	mHeight = height;
+	// The last scene has the old aspect
+	mSinceScene = MAX_INTERVAL;
 
 	glViewport(0, 0, width, height);
 	mFramebuffer->setDemensions(width, height);
 }
 
-void Renderer::draw() const {
+// Y4M only has a constant frame rate, interactive captures are assumed to keep up with the display
+void Renderer::startCapture(const std::string& directory) const {
+	mFramebuffer->startCapture(directory, mOwner->getOptions().format, mRefreshRate);
+}
+
+bool Renderer::isVisible() const {
+	if (mWindow == nullptr) {
+		return true;
+	}
+
+	return (SDL_GetWindowFlags(mWindow) &
+			(SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED | SDL_WINDOW_OCCLUDED)) == 0;
+}
+
+void Renderer::snapshot() {
+	PROFILE_SCOPE("Renderer::snapshot");
+
+	snapshotCamera();
+
+	mSceneProjection = mProjection;
+	if (mReproject) {
+		mSceneProjection(0, 0) /= GUARD_BAND;
+		mSceneProjection(1, 1) /= GUARD_BAND;
+	}
+	const Eigen::Matrix4f viewProjection = mSceneProjection * mView.matrix();
+
+	// The occluders are drawn first, so the lanes only test against the finished buffer
+	if (mOcclude) {
+		PROFILE_SCOPE("Occlusion");
+
+		mOcclusion->begin(viewProjection, mCamera->getNear());
+		for (DrawComponent* drawable : mDrawables) {
+			if (drawable->isOccluder()) {
+				drawable->occlude(*mOcclusion);
+			}
+		}
+		mOcclusion->rasterize(*mWorkers);
+	}
+
+	// Every slice of the drawables records into its own lane, which are joined in order, so the
+	// queue ends up the same whichever thread takes a slice
+	const size_t lanes = mWorkers->chunks(mDrawables.size(), RECORD_GRAIN);
+	mQueue->clear(mEye, mCamera->getFar(), lanes);
+	mWorkers->run(mDrawables.size(), lanes, [this](size_t lane, size_t begin, size_t end) {
+		PROFILE_SCOPE("Record");
+
+		for (size_t i = begin; i < end; i++) {
+			mDrawables[i]->record(mQueue->getLane(lane));
+		}
+	});
+
+	mQueue->cull(viewProjection, mOcclude ? mOcclusion.get() : nullptr);
+	mQueue->sort();
+	mLights->update(mView, mSceneProjection, mCamera->getNear(), mCamera->getFar());
+}
+
+void Renderer::snapshotCamera() {
+	mView = mCamera->getViewMatrix();
+	mProjection = mCamera->getProjectionMatrix().matrix();
+	mEye = mCamera->getOwner()->getPosition();
+}
+
+void Renderer::draw() {
 #ifdef IMGUI
 	ImGui::Render();
 #endif
 
+	PROFILE_SCOPE("Renderer::draw");
+
+	if (!sceneDue()) {
+		present();
+
+		return;
+	}
+
+	mFramebuffer->begin();
+	mProfiler->begin("Scene");
+
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	for (const auto& sprite : mDrawables) {
-		Shader* const shader = sprite->getShader();
-		shader->activate();
-		shader->set("viewPos", mCamera->getOwner()->getPosition()); // Bruh how come I forgot
-		shader->set("view", mCamera->getViewMatrix());
-		shader->set("proj", mCamera->getProjectionMatrix());
+	// Waiting for the GPU comes first when latency matters, so that the camera turns as late as
+	// possible and culling sees where it ends up
+	if (mLowLatency) {
+		FrameSync::begin();
+		mCamera->latch();
+		snapshot();
+	}
+
+	mSceneRotation = mView.linear();
+	mSceneScale = Eigen::Vector2f(mSceneProjection(0, 0), mSceneProjection(1, 1));
 
-		setLights(shader);
+	// The snapshot was taken while the GPU finished the older frames
+	if (!mLowLatency) {
+		FrameSync::begin();
+	}
+	mRing->begin();
+
+	// Write everything the frame reads first, the buffer can't be written to while drawing
+	// unless it is persistently mapped
+	GLintptr frameOffset = 0;
+	FrameData* const frame =
+		static_cast<FrameData*>(mRing->allocate(sizeof(FrameData), mUniformAlignment, frameOffset));
+	if (frame != nullptr) {
+		setFrame(*frame);
+	}
+
+	GLintptr lightsOffset = 0;
+	void* const lights = mRing->allocate(LightManager::BLOCK_SIZE, mUniformAlignment, lightsOffset);
+	if (lights != nullptr) {
+		mLights->write(lights);
+	}
+
+	// Without its blocks the scene isn't drawn this frame, binding offset 0 instead would read
+	// another frame's data
+	const bool blocks = frame != nullptr && lights != nullptr;
+
+	// The models of all packets in their order, each run draws its slice of them
+	const std::vector<DrawPacket>& packets = mQueue->packets();
+	GLintptr modelsOffset = 0;
+	float* const models =
+		blocks ? static_cast<float*>(mRing->allocate(packets.size() * sizeof(Eigen::Matrix4f),
+													 sizeof(Eigen::Matrix4f), modelsOffset))
+			   : nullptr;
+
+	// Packets of the same program and mesh are next to each other after sorting
+	mRuns.clear();
+	for (size_t i = 0; models != nullptr && i < packets.size();) {
+		size_t end = i;
+		while (end < packets.size() && packets[end].shader == packets[i].shader &&
+			   packets[end].mesh == packets[i].mesh) {
+			end++;
+		}
+
+		mRuns.emplace_back(Run{i, end - i,
+							   modelsOffset + static_cast<GLintptr>(i * sizeof(Eigen::Matrix4f))});
+
+		i = end;
+	}
 
-		sprite->draw();
+	// Dropped for this frame when the region is full, the ring buffer grows for the next one
+	if (models != nullptr) {
+		const auto write = [&packets, models](size_t, size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				Eigen::Map<Eigen::Matrix4f>(models + i * 16) = packets[i].model.matrix();
+			}
+		};
+		mWorkers->run(packets.size(), mWorkers->chunks(packets.size(), MODEL_GRAIN), write);
 	}
 
-	mFramebuffer->swap(mWindow);
+	mRing->commit();
+
+	if (blocks) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, Shader::FRAME_BINDING, mRing->getBuffer(),
+						  frameOffset, sizeof(FrameData));
+		glBindBufferRange(GL_UNIFORM_BUFFER, Shader::LIGHTS_BINDING, mRing->getBuffer(),
+						  lightsOffset, LightManager::BLOCK_SIZE);
+		mLights->bind();
+	}
+
+	const Shader* shader = nullptr;
+	const std::vector<std::pair<Texture*, TextureType>>* textures = nullptr;
+
+	for (const Run& run : mRuns) {
+		const DrawPacket& packet = packets[run.first];
+
+		if (packet.shader != shader) {
+			if (mPool) {
+				mPool->flush();
+			}
+
+			// Every program is its own pass, the layers keep them mostly together
+			if (shader != nullptr) {
+				mProfiler->end();
+			}
+			mProfiler->begin(packet.shader->getName());
+
+			shader = packet.shader;
+			shader->activate();
+
+			textures = nullptr;
+		}
+
+		const Mesh* const mesh = packet.mesh;
+		if (textures == nullptr || *textures != mesh->getTextures()) {
+			// The queued pooled draws use the old textures
+			if (mPool) {
+				mPool->flush();
+			}
+
+			textures = &mesh->getTextures();
+			mesh->bindTextures(shader);
+		}
+
+		// Pooled meshes are batched until the program or textures change
+		if (mesh->isPooled()) {
+			mPool->add(mesh->getAllocation(), mRing->getBuffer(), run.offset, run.count);
+		} else {
+			mesh->bind();
+			mesh->drawInstanced(mRing->getBuffer(), run.offset, run.count);
+		}
+	}
+
+	if (mPool) {
+		mPool->flush();
+	}
+
+	if (shader != nullptr) {
+		mProfiler->end();
+	}
+
+	mProfiler->end();
+
+	mFramebuffer->swap(mWindow, reprojection());
+	mProfiler->frame();
+	FrameSync::end();
+
+	GLState::frame();
+}
+
+bool Renderer::sceneDue() {
+	// Captures get every frame
+	if (!mReproject || mFramebuffer->isCapturing()) {
+		mSinceScene = 0;
+
+		return true;
+	}
+
+	unsigned int interval = mInterval;
+	if (interval == 0) {
+		// As many refreshes as the scene takes, two without timer queries
+		const float time = mFramebuffer->getGPUTime();
+
+		interval = 2;
+		if (time > 0.0f) {
+			interval = static_cast<unsigned int>(std::ceil(time / mFramebuffer->getBudget()));
+		}
+		interval = std::clamp(interval, 1u, MAX_INTERVAL);
+	}
+
+	if (++mSinceScene < interval) {
+		return false;
+	}
+
+	mSinceScene = 0;
+
+	return true;
+}
+
+void Renderer::present() {
+	FrameSync::begin();
+	if (mLowLatency) {
+		mCamera->latch();
+		snapshotCamera();
+	}
+
+	mFramebuffer->present(mWindow, reprojection());
+	mProfiler->frame();
+	FrameSync::end();
+
+	GLState::frame();
+}
+
+// The scene is far enough for the rotation to be all that matters, so the rays of the camera are
+// turned into the view of the last scene and projected with its projection
+Eigen::Matrix3f Renderer::reprojection() const {
+	if (!mReproject) {
+		return Eigen::Matrix3f::Identity();
+	}
+
+	const Eigen::Matrix4f& projection = mProjection;
+	const Eigen::Matrix3f rotation = mSceneRotation * mView.linear().transpose();
+
+	// Rays look down -z, so z is negated to get the homogeneous w
+	const Eigen::Vector3f scene(mSceneScale.x(), mSceneScale.y(), -1.0f);
+	const Eigen::Vector3f camera(1.0f / projection(0, 0), 1.0f / projection(1, 1), -1.0f);
+
+	return scene.asDiagonal() * rotation * camera.asDiagonal();
 }
 
 void Renderer::reload() const {
@@ -123,7 +510,37 @@ void Renderer::reload() const {
 	}
 }
 
+void Renderer::reloadModel(const std::string& file) const {
+	const std::filesystem::path directory =
+		std::filesystem::path(file).lexically_normal().parent_path();
+
+	for (const auto& sprite : mDrawables) {
+		ModelComponent* const model = dynamic_cast<ModelComponent*>(sprite);
+		if (model == nullptr ||
+			std::filesystem::path(model->getPath()).lexically_normal().parent_path() != directory) {
+			continue;
+		}
+
+		try {
+			model->load();
+		} catch (const std::runtime_error& error) {
+			SDL_Log("Error reloading model %s: %s", model->getPath().data(), error.what());
+		}
+	}
+}
+
+void Renderer::checkThread() const {
+	[[unlikely]] if (std::this_thread::get_id() != mThread) {
+		SDL_LogError(SDL_LOG_CATEGORY_RENDER,
+					 "Drawables and lights have to be made on the main thread, see Game::spawn\n");
+
+		throw std::runtime_error("renderer.cpp: Drawable made off the thread of the context");
+	}
+}
+
 void Renderer::addSprite(DrawComponent* sprite) {
+	checkThread();
+
 	// Preserve order
 	int order = sprite->getDrawOrder();
 	auto iter = mDrawables.begin();
@@ -141,24 +558,23 @@ void Renderer::removeSprite(DrawComponent* sprite) {
 	mDrawables.erase(iter);
 }
 
-void Renderer::setLights(Shader* shader) const {
-	const Eigen::Vector4f lightPos(1.2f, 1.0f, 2.0f, 1.0f);
+void Renderer::addLight(LightComponent* light) {
+	checkThread();
+
+	mLights->add(light);
+}
+
+void Renderer::removeLight(LightComponent* light) { mLights->remove(light); }
 
-	shader->set("dirLight.direction", -0.2f, -1.0f, -0.3f);
-	shader->set("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-	shader->set("dirLight.diffuse", 0.5f, 0.5f, 0.5f);
-	shader->set("dirLight.specular", 0.5f, 0.5f, 0.5f);
+void Renderer::setFrame(FrameData& frame) const {
+	frame.view = mView.matrix();
+	frame.proj = mSceneProjection;
+	frame.viewPos = mEye;
 
-	// TODO: Point light
+	frame.dirLight.direction = Eigen::Vector3f(-0.2f, -1.0f, -0.3f);
+	frame.dirLight.ambient = Eigen::Vector3f(0.05f, 0.05f, 0.05f);
+	frame.dirLight.diffuse = Eigen::Vector3f(0.5f, 0.5f, 0.5f);
+	frame.dirLight.specular = Eigen::Vector3f(0.5f, 0.5f, 0.5f);
 
-	shader->set("spotLight.position", mCamera->getOwner()->getPosition());
-	shader->set("spotLight.direction", mCamera->getOwner()->getForward());
-	shader->set("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-	shader->set("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-	shader->set("spotLight.specular", 1.0f, 1.0f, 1.0f);
-	shader->set("spotLight.constant", 1.0f);
-	shader->set("spotLight.linear", 0.09f);
-	shader->set("spotLight.quadratic", 0.032f);
-	shader->set("spotLight.cutOff", cos(toRadians(12.5f)));
-	shader->set("spotLight.outerCutOff", cos(toRadians(15.0f)));
+	frame.lightSlicing = mLights->getSlicing();
 }
@@ -0,0 +1,143 @@
+#include "opengl/ringBuffer.hpp"
+
+#include "managers/glManager.hpp"
+#include "opengl/frameSync.hpp"
+#include "third_party/glad/glad.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+RingBuffer::RingBuffer(GLsizeiptr size)
+	: mBuffer(0), mSize(size), mOffset(0), mFrame(0), mGrow(false), mMapped(nullptr),
+	  mStaged(false), mBufferStorage(nullptr) {
+#ifdef GLES
+	const char* extension = "GL_EXT_buffer_storage";
+	const char* function = "glBufferStorageEXT";
+#else
+	const char* extension = "GL_ARB_buffer_storage";
+	const char* function = "glBufferStorage";
+#endif
+
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+#ifdef GLES
+	const bool core = false;
+#else
+	const bool core = major > 4 || (major == 4 && minor >= 4);
+#endif
+
+	if (core || GLManager::extensionSupported(extension)) {
+		mBufferStorage = reinterpret_cast<BufferStorageProc>(GLManager::getProcAddress(function));
+	}
+
+#ifdef __EMSCRIPTEN__
+	SDL_Log("Ring buffer: uploaded every frame");
+#else
+	SDL_Log("Ring buffer: %s", isPersistent() ? "persistently mapped" : "mapped every frame");
+#endif
+
+	create();
+}
+
+RingBuffer::~RingBuffer() { release(); }
+
+void RingBuffer::create() {
+	glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+
+	if (isPersistent()) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		mBufferStorage(GL_COPY_WRITE_BUFFER, mSize * FRAMES, nullptr, flags);
+		mMapped = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, mSize * FRAMES, flags));
+	} else {
+		glBufferData(GL_COPY_WRITE_BUFFER, mSize * FRAMES, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+// Deleting the buffer unmaps it, which has to wait until the frames in flight are done with it
+void RingBuffer::release() {
+	const GLuint buffer = mBuffer;
+	FrameSync::defer([buffer] { glDeleteBuffers(1, &buffer); });
+
+	mMapped = nullptr;
+	mBuffer = 0;
+}
+
+void RingBuffer::begin() {
+	// The frames in flight keep reading from the old buffer
+	if (mGrow) {
+		release();
+
+		mSize = std::min(mSize * 2, MAX_SIZE);
+		mGrow = false;
+		SDL_Log("Growing the ring buffer to %ld bytes per frame", static_cast<long>(mSize));
+
+		create();
+	}
+
+	mFrame = FrameSync::getFrame();
+	mOffset = 0;
+
+	if (!isPersistent()) {
+		// Emscripten only maps whole buffers, into memory it uploads on unmap anyway
+#ifndef __EMSCRIPTEN__
+		// The frame's fence already synchronized, so don't let the driver do it again
+		glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+		mMapped = static_cast<char*>(glMapBufferRange(
+			GL_COPY_WRITE_BUFFER, mFrame * mSize, mSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+#endif
+
+		mStaged = mMapped == nullptr;
+		if (mStaged) {
+			mStaging.resize(mSize);
+			mMapped = mStaging.data();
+		}
+	}
+}
+
+void* RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset) {
+	const GLsizeiptr aligned = (mOffset + alignment - 1) / alignment * alignment;
+
+	[[unlikely]] if (mMapped == nullptr) {
+		return nullptr;
+	}
+
+	[[unlikely]] if (aligned + size > mSize) {
+		mGrow = mSize < MAX_SIZE;
+
+		return nullptr;
+	}
+
+	mOffset = aligned + size;
+	offset = mFrame * mSize + aligned;
+
+	// Persistent maps cover every region, the others only the current one
+	return mMapped + (isPersistent() ? offset : aligned);
+}
+
+void RingBuffer::commit() {
+	if (isPersistent() || mMapped == nullptr) {
+		return;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+	if (mStaged) {
+		glBufferSubData(GL_COPY_WRITE_BUFFER, mFrame * mSize, mOffset, mStaging.data());
+	} else {
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+
+	mMapped = nullptr;
+}
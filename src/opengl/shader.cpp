@@ -1,23 +1,30 @@
 #include "opengl/shader.hpp"
+#include "opengl/glState.hpp"
 #include "utils.hpp"
 
 #include "third_party/Eigen/Dense"
 #include "third_party/glad/glad.h"
 
 #include <SDL3/SDL.h>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <functional>
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 
-Shader::Shader(const std::string_view& vertName, const std::string_view& fragName)
-	: mShaderProgram(glCreateProgram()) {
+Shader::Shader(const std::string_view& vertName, const std::string_view& vertSource,
+			   const std::string_view& fragName, const std::string_view& fragSource,
+			   const std::string_view& defines)
+	: mShaderProgram(glCreateProgram()), mName(fragName) {
 	GLuint mVertexShader = 0;
 	GLuint mFragmentShader = 0;
 
-	compile(vertName, GL_VERTEX_SHADER, mVertexShader);
-	compile(fragName, GL_FRAGMENT_SHADER, mFragmentShader);
+	compile(vertName, vertSource, defines, GL_VERTEX_SHADER, mVertexShader);
+	compile(fragName, fragSource, defines, GL_FRAGMENT_SHADER, mFragmentShader);
 
 	glAttachShader(mShaderProgram, mVertexShader);
 	glAttachShader(mShaderProgram, mFragmentShader);
@@ -41,18 +48,69 @@ Shader::Shader(const std::string_view& vertName, const std::string_view& fragNam
 
 		throw std::runtime_error("Shader.cpp: Failed to link shader");
 	}
+
+	// No binding layout qualifier before GLSL 4.20 and on GLES 3.0
+	const GLuint frame = glGetUniformBlockIndex(mShaderProgram, "Frame");
+	if (frame != GL_INVALID_INDEX) {
+		glUniformBlockBinding(mShaderProgram, frame, FRAME_BINDING);
+	}
+	const GLuint lights = glGetUniformBlockIndex(mShaderProgram, "Lights");
+	if (lights != GL_INVALID_INDEX) {
+		glUniformBlockBinding(mShaderProgram, lights, LIGHTS_BINDING);
+	}
+
+	GLint count = 0;
+	GLint length = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &length);
+
+	std::string name(static_cast<size_t>(std::max(length, 1)), '\0');
+	for (GLint i = 0; i < count; i++) {
+		GLsizei written = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(mShaderProgram, static_cast<GLuint>(i), length, &written, &size, &type,
+						   name.data());
+
+		std::string uniform = name.substr(0, static_cast<size_t>(written));
+		// Members of uniform blocks have no location
+		const GLint location = glGetUniformLocation(mShaderProgram, uniform.data());
+		if (location == -1) {
+			continue;
+		}
+
+		// Arrays are listed once as "name[0]"
+		if (uniform.ends_with("[0]")) {
+			uniform.resize(uniform.size() - 3);
+
+			for (GLint element = 0; element < size; element++) {
+				const std::string indexed = uniform + "[" + std::to_string(element) + "]";
+				mLocations[indexed] = glGetUniformLocation(mShaderProgram, indexed.data());
+			}
+		}
+
+		mLocations[uniform] = location;
+	}
+
+	// The cluster textures stay on their units, so their samplers are only set once
+	if (mLocations.contains("lightGrid")) {
+		activate();
+		set("lightGrid", LIGHT_GRID_UNIT);
+		set("lightIndices", LIGHT_INDEX_UNIT);
+	}
 }
 
 Shader::~Shader() {
 #ifndef ADDRESS
-	glDeleteProgram(mShaderProgram);
+	GLState::deleteProgram(mShaderProgram);
 #endif
 }
 
-void Shader::activate() const { glUseProgram(mShaderProgram); }
+void Shader::activate() const { GLState::useProgram(mShaderProgram); }
 
 void Shader::setUniform(const std::string_view& name, std::function<void(GLint)> toCall) const {
-	int location = glGetUniformLocation(mShaderProgram, name.data());
+	const auto found = mLocations.find(name);
+	const GLint location = found == mLocations.end() ? -1 : found->second;
 
 #ifdef DEBUG
 	static std::unordered_map<std::string, bool> errored;
@@ -108,43 +166,33 @@ void Shader::set(const std::string_view& name, const Eigen::Vector4f& val) const
 	setUniform(name,
 			   std::bind(glUniform4f, std::placeholders::_1, val.x(), val.y(), val.z(), val.w()));
 }
+void Shader::set(const std::string_view& name, const Eigen::Matrix3f& mat) const {
+	setUniform(name,
+			   std::bind(glUniformMatrix3fv, std::placeholders::_1, 1, GL_FALSE, mat.data()));
+}
 void Shader::set(const std::string_view& name, const Eigen::Affine3f& mat,
 				 const GLboolean& transpose) const {
 	setUniform(name,
 			   std::bind(glUniformMatrix4fv, std::placeholders::_1, 1, transpose, mat.data()));
 }
 
-void Shader::compile(const std::string_view& fileName, const GLenum& type, GLuint& out) {
-	char* shaderSource = static_cast<char*>(SDL_LoadFile(fileName.data(), nullptr));
-#ifdef GLES
-	// #version 400 core
-	// to
-	// #version 300 es
-	shaderSource[9] = '3';
-	shaderSource[13] = 'e';
-	shaderSource[14] = 's';
-	shaderSource[15] = ' ';
-	shaderSource[16] = ' ';
-#endif
+void Shader::compile(const std::string_view& name, const std::string_view& source,
+					 const std::string_view& defines, const GLenum& type, GLuint& out) {
+	SDL_Log("Loading %s", name.data());
 
-	[[unlikely]] if (shaderSource == nullptr) {
-		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to read shader shource %s: %s\n",
-						fileName.data(), SDL_GetError());
+	// The source already starts with the #version of the target, the defines go right after it
+	const size_t version = std::min(source.find('\n'), source.size() - 1) + 1;
 
-#ifndef DEBUG
-		ERROR_BOX("Failed to read assets");
-#endif
-
-		throw std::runtime_error("shader.cpp: Failed to read shader source");
-	}
-	SDL_Log("Loading %s", fileName.data());
+	const std::array<const GLchar*, 3> parts = {source.data(), defines.data(),
+												source.data() + version};
+	const std::array<GLint, 3> lengths = {static_cast<GLint>(version),
+										  static_cast<GLint>(defines.size()),
+										  static_cast<GLint>(source.size() - version)};
 
 	out = glCreateShader(type);
-	glShaderSource(out, 1, &shaderSource, nullptr);
+	glShaderSource(out, parts.size(), parts.data(), lengths.data());
 	glCompileShader(out);
 
-	SDL_free(shaderSource);
-
 	// Error checking
 	GLint success = 0;
 	glGetShaderiv(out, GL_COMPILE_STATUS, &success);
@@ -155,7 +203,7 @@ void Shader::compile(const std::string_view& fileName, const GLenum& type, GLuin
 
 		glGetShaderInfoLog(out, len * sizeof(GLchar), nullptr, &log[0]);
 		SDL_LogCritical(SDL_LOG_CATEGORY_VIDEO, "Failed to compile shader %s: \n%s\n",
-						fileName.data(), log);
+						name.data(), log);
 
 		ERROR_BOX("Failed to compile shader");
 
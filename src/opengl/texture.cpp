@@ -1,5 +1,7 @@
 #include "opengl/texture.hpp"
 
+#include "opengl/glState.hpp"
+#include "profiler.hpp"
 #include "third_party/glad/glad.h"
 #include "third_party/stb_image.h"
 #include "utils.hpp"
@@ -12,20 +14,40 @@ Texture::Texture(const std::string_view& path) : name(path) {}
 
 Texture::~Texture() {
 #ifndef ADDRESS
-	glDeleteTextures(1, &mID);
+	GLState::deleteTexture(mID);
 #endif
 
 	SDL_Log("Unloading texture %s", name.data());
 }
 
 void Texture::activate(const unsigned int& num) const {
-	glActiveTexture(GL_TEXTURE0 + num);
-	glBindTexture(GL_TEXTURE_2D, mID);
+	GLState::bindTexture(num, GL_TEXTURE_2D, mID);
+}
+
+// Loaded into a new texture, so a file caught half written keeps showing the old one
+void Texture::reload() {
+	const GLuint old = mID;
+
+	try {
+		load();
+	} catch (const std::runtime_error&) {
+		// Cubemaps make the texture before loading the faces
+		if (mID != old) {
+			GLState::deleteTexture(mID);
+		}
+		mID = old;
+
+		throw;
+	}
+
+	GLState::deleteTexture(old);
 }
 
 // NOTE: Maybe load on demand?
 
 void Texture::load() {
+	PROFILE_SCOPE("Texture::load");
+
 	SDL_Log("Loading texture %s", name.data());
 
 	int width = 0;
@@ -60,7 +82,7 @@ void Texture::load() {
 	}
 
 	glGenTextures(1, &mID);
-	glBindTexture(GL_TEXTURE_2D, mID);
+	GLState::bindTexture(GL_TEXTURE_2D, mID);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 	glGenerateMipmap(GL_TEXTURE_2D);
@@ -0,0 +1,127 @@
+#include "options.hpp"
+
+#include "opengl/capture.hpp"
+
+#include <SDL3/SDL.h>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+
+static void usage() {
+	SDL_Log("Usage: ./Panorama [--size WxH] [--frames N] [--output directory] "
+			"[--format ppm|y4m|raw] [--trace file] [--benchmark report] [--path file] "
+			"[--record file] [--low-latency delay] [--reproject interval] [--threads N] file");
+}
+
+std::optional<Options> Options::parse(int argc, char** argv) {
+	Options options;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string_view arg = argv[i];
+
+		// Every option takes a value
+		if (arg.starts_with("--") && i + 1 >= argc) {
+			SDL_Log("Missing the value of %s", argv[i]);
+			usage();
+
+			return std::nullopt;
+		}
+
+		if (arg == "--size") {
+			const char* value = argv[++i];
+			char* end = nullptr;
+
+			options.width = static_cast<int>(std::strtol(value, &end, 10));
+			if (*end != 'x' || options.width <= 0) {
+				SDL_Log("Malformed size %s", value);
+
+				return std::nullopt;
+			}
+
+			options.height = static_cast<int>(std::strtol(end + 1, &end, 10));
+			if (*end != '\0' || options.height <= 0) {
+				SDL_Log("Malformed size %s", value);
+
+				return std::nullopt;
+			}
+		} else if (arg == "--frames") {
+			const char* value = argv[++i];
+			char* end = nullptr;
+
+			options.frames = static_cast<unsigned int>(std::strtoul(value, &end, 10));
+			if (*end != '\0') {
+				SDL_Log("Malformed frame count %s", value);
+
+				return std::nullopt;
+			}
+		} else if (arg == "--output") {
+			options.output = argv[++i];
+		} else if (arg == "--format") {
+			if (!Capture::parseFormat(argv[++i], options.format)) {
+				SDL_Log("Unknown capture format %s", argv[i]);
+				usage();
+
+				return std::nullopt;
+			}
+		} else if (arg == "--trace") {
+			options.trace = argv[++i];
+#ifndef PROFILE
+			SDL_Log("Built without PROFILE, no trace is written");
+#endif
+		} else if (arg == "--benchmark") {
+			options.benchmark = argv[++i];
+		} else if (arg == "--path") {
+			options.path = argv[++i];
+		} else if (arg == "--record") {
+			options.record = argv[++i];
+		} else if (arg == "--low-latency") {
+			const char* value = argv[++i];
+			char* end = nullptr;
+
+			options.lowLatency = true;
+			options.delay = static_cast<unsigned int>(std::strtoul(value, &end, 10));
+			if (*end != '\0') {
+				SDL_Log("Malformed delay %s", value);
+
+				return std::nullopt;
+			}
+		} else if (arg == "--reproject") {
+			const char* value = argv[++i];
+			char* end = nullptr;
+
+			options.reproject = true;
+			options.interval = static_cast<unsigned int>(std::strtoul(value, &end, 10));
+			if (*end != '\0') {
+				SDL_Log("Malformed interval %s", value);
+
+				return std::nullopt;
+			}
+		} else if (arg == "--threads") {
+			const char* value = argv[++i];
+			char* end = nullptr;
+
+			options.threads = static_cast<unsigned int>(std::strtoul(value, &end, 10));
+			if (*end != '\0') {
+				SDL_Log("Malformed thread count %s", value);
+
+				return std::nullopt;
+			}
+		} else if (arg.starts_with("--") || !options.pano.empty()) {
+			SDL_Log("Unknown argument %s", argv[i]);
+			usage();
+
+			return std::nullopt;
+		} else {
+			options.pano = argv[i];
+		}
+	}
+
+	if (options.pano.empty()) {
+		usage();
+
+		return std::nullopt;
+	}
+
+	return options;
+}
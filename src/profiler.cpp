@@ -0,0 +1,164 @@
+#include "profiler.hpp"
+
+#ifdef PROFILE
+#include <SDL3/SDL.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const std::chrono::steady_clock::time_point EPOCH = std::chrono::steady_clock::now();
+
+thread_local Profiler::Buffer* Profiler::mBuffer = nullptr;
+
+std::mutex Profiler::mMutex;
+std::vector<Profiler::Buffer*> Profiler::mBuffers;
+
+uint64_t Profiler::mFrameStart = 0;
+uint64_t Profiler::mLastFrameStart = 0;
+uint64_t Profiler::mLastFrameEnd = 0;
+
+uint64_t Profiler::now() {
+	const std::chrono::steady_clock::duration time = std::chrono::steady_clock::now() - EPOCH;
+
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+Profiler::Buffer& Profiler::buffer() {
+	if (mBuffer == nullptr) {
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		mBuffer = new Buffer();
+		mBuffer->id = static_cast<unsigned int>(mBuffers.size());
+		mBuffer->name = "Thread " + std::to_string(mBuffer->id);
+		mBuffer->count = 0;
+		mBuffer->depth = 0;
+
+		mBuffers.emplace_back(mBuffer);
+	}
+
+	return *mBuffer;
+}
+
+void Profiler::setThreadName(const char* name) {
+	Buffer& buf = buffer();
+
+	const std::lock_guard<std::mutex> lock(buf.mutex);
+	buf.name = name;
+}
+
+void Profiler::push() { buffer().depth++; }
+
+void Profiler::pop(const char* name, uint64_t start) {
+	Buffer& buf = buffer();
+	buf.depth--;
+
+	const uint64_t end = now();
+
+	const std::lock_guard<std::mutex> lock(buf.mutex);
+	buf.events[buf.count % CAPACITY] = {name, start, end, buf.depth};
+	buf.count++;
+}
+
+void Profiler::frame() {
+	const uint64_t time = now();
+
+	mLastFrameStart = mFrameStart;
+	mLastFrameEnd = time;
+	mFrameStart = time;
+}
+
+void Profiler::getFrame(uint64_t& start, uint64_t& end) {
+	if (mLastFrameStart == 0) {
+		start = 0;
+		end = 0;
+
+		return;
+	}
+
+	start = mLastFrameStart;
+	end = mLastFrameEnd;
+}
+
+std::vector<Profiler::Thread> Profiler::collect(uint64_t start, uint64_t end) {
+	std::vector<Thread> threads;
+
+	const std::lock_guard<std::mutex> lock(mMutex);
+	threads.reserve(mBuffers.size());
+
+	for (Buffer* buf : mBuffers) {
+		const std::lock_guard<std::mutex> bufLock(buf->mutex);
+
+		Thread& thread = threads.emplace_back(Thread{buf->name, buf->id, {}});
+
+		const uint64_t first = buf->count > CAPACITY ? buf->count - CAPACITY : 0;
+		for (uint64_t i = first; i < buf->count; i++) {
+			const Event& event = buf->events[i % CAPACITY];
+
+			if (event.end >= start && event.end <= end) {
+				thread.events.emplace_back(event);
+			}
+		}
+	}
+
+	return threads;
+}
+
+// Only what the names need, they are literals from the code
+static void escape(std::string& out, const char* text) {
+	for (const char* c = text; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			out += '\\';
+		}
+		out += *c;
+	}
+}
+
+bool Profiler::write(const std::string& path) {
+	const std::vector<Thread> threads = collect(0, UINT64_MAX);
+
+	std::string out = "{\"traceEvents\":[\n";
+	std::array<char, 128> number;
+	bool first = true;
+
+	for (const Thread& thread : threads) {
+		if (!first) {
+			out += ",\n";
+		}
+		first = false;
+
+		out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+		out += std::to_string(thread.id) + ",\"args\":{\"name\":\"";
+		escape(out, thread.name.data());
+		out += "\"}}";
+
+		for (const Event& event : thread.events) {
+			out += ",\n{\"name\":\"";
+			escape(out, event.name);
+
+			// Microseconds
+			std::snprintf(number.data(), number.size(),
+						  "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+						  thread.id, static_cast<double>(event.start) / 1000.0,
+						  static_cast<double>(event.end - event.start) / 1000.0);
+			out += number.data();
+		}
+	}
+
+	out += "\n]}\n";
+
+	if (!SDL_SaveFile(path.data(), out.data(), out.size())) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the trace %s: %s\n",
+					 path.data(), SDL_GetError());
+
+		return false;
+	}
+
+	SDL_Log("Wrote the trace to %s", path.data());
+
+	return true;
+}
+#endif
@@ -0,0 +1,132 @@
+#include "threadPool.hpp"
+
+#include "profiler.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+// Chunks per thread, so that a thread that finishes early can take some of the others' work
+static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+ThreadPool::ThreadPool(unsigned int threads)
+	: mRunning(true), mGeneration(0), mBusy(0), mFunction(nullptr), mCount(0), mChunks(0), mNext(0),
+	  mRemaining(0) {
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+#ifdef __EMSCRIPTEN__
+	// Built without pthreads
+	threads = 1;
+#endif
+
+	const unsigned int workers = threads - 1;
+
+	for (unsigned int i = 0; i < workers; i++) {
+		mWorkers.emplace_back(&ThreadPool::work, this);
+	}
+
+	SDL_Log("Started %u worker threads", workers);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+	mWake.notify_all();
+
+	for (std::thread& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+size_t ThreadPool::chunks(size_t count, size_t grain) const {
+	const size_t most = (count + std::max(grain, size_t{1}) - 1) / std::max(grain, size_t{1});
+
+	return std::clamp(getThreads() * CHUNKS_PER_THREAD, size_t{1}, std::max(most, size_t{1}));
+}
+
+void ThreadPool::run(size_t count, size_t chunks, const Function& function) {
+	if (count == 0) {
+		return;
+	}
+
+	chunks = std::clamp(chunks, size_t{1}, count);
+
+	// Not worth waking anyone
+	if (chunks == 1 || mWorkers.empty()) {
+		for (size_t chunk = 0; chunk < chunks; chunk++) {
+			function(chunk, chunk * count / chunks, (chunk + 1) * count / chunks);
+		}
+
+		return;
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		mFunction = &function;
+		mCount = count;
+		mChunks = chunks;
+		mNext.store(0);
+		mRemaining.store(chunks);
+		mGeneration++;
+	}
+	mWake.notify_all();
+
+	help();
+
+	// The workers still inside of help could read the next run's state
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [this] { return mRemaining.load() == 0 && mBusy == 0; });
+}
+
+void ThreadPool::help() {
+	while (true) {
+		const size_t chunk = mNext.fetch_add(1);
+		if (chunk >= mChunks) {
+			return;
+		}
+
+		(*mFunction)(chunk, chunk * mCount / mChunks, (chunk + 1) * mCount / mChunks);
+
+		if (mRemaining.fetch_sub(1) == 1) {
+			const std::lock_guard<std::mutex> lock(mMutex);
+			mDone.notify_all();
+		}
+	}
+}
+
+void ThreadPool::work() {
+	PROFILE_THREAD("Worker");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	uint64_t seen = 0;
+
+	while (true) {
+		mWake.wait(lock, [this, seen] { return !mRunning || mGeneration != seen; });
+		if (!mRunning) {
+			return;
+		}
+
+		// A run that is already done must not be joined, its caller might have returned
+		seen = mGeneration;
+		if (mRemaining.load() == 0) {
+			continue;
+		}
+
+		mBusy++;
+		lock.unlock();
+
+		help();
+
+		lock.lock();
+		mBusy--;
+		if (mBusy == 0) {
+			mDone.notify_all();
+		}
+	}
+}